@@ -1,10 +1,72 @@
+#pragma once
+
+#include <cstddef>
+
 #include <CL/cl.h>
 
+#include "deviceVector.hpp"
+#include "session.hpp"
+
+/**
+ * Bytes moved between host and device by host-pointer *_ocl calls.
+ * Strided vectors (inc > 1) are packed on the host, so only elements used by the kernel are transferred.
+ */
+struct TransferStats {
+    size_t bytes = 0;
+    size_t bytesSaved = 0;
+};
+
+// One operation y = a * x + y of a batch
+template <typename T>
+struct AxpyBatchItem {
+    int n;
+    T a;
+    T *x;
+    int incx;
+    T *y;
+    int incy;
+};
+
+// Plain loops, the reference for all other variants
 void saxpy(int n, float a, float *x, int incx, float *y, int incy);
 void daxpy(int n, double a, double *x, int incx, double *y, int incy);
 
+// Kernels of simd.hpp for the running CPU, FMA variants round once and may differ from saxpy in the last bit
+void saxpy_simd(int n, float a, float *x, int incx, float *y, int incy);
+void daxpy_simd(int n, double a, double *x, int incx, double *y, int incy);
+
 void saxpy_ocl(int n, float a, float *x, int incx, float *y, int incy, cl_device_id deviceId, double *elapsed = nullptr);
 void daxpy_ocl(int n, double a, double *x, int incx, double *y, int incy, cl_device_id deviceId, double *elapsed = nullptr);
 
+void saxpy_ocl(int n, float a, float *x, int incx, float *y, int incy, Session &session, double *elapsed = nullptr,
+               TransferStats *transfer = nullptr);
+void daxpy_ocl(int n, double a, double *x, int incx, double *y, int incy, Session &session, double *elapsed = nullptr,
+               TransferStats *transfer = nullptr);
+
+void saxpy_ocl(int n, float a, const DeviceVector<float> &x, int incx, DeviceVector<float> &y, int incy,
+               double *elapsed = nullptr);
+void daxpy_ocl(int n, double a, const DeviceVector<double> &x, int incx, DeviceVector<double> &y, int incy,
+               double *elapsed = nullptr);
+
+// Streams the vectors through the device in chunks overlapping transfers and computation, chunk <= 0 picks the size
+void saxpy_ocl_pipelined(int n, float a, float *x, int incx, float *y, int incy, Session &session, int chunk = 0,
+                         double *elapsed = nullptr);
+void daxpy_ocl_pipelined(int n, double a, double *x, int incx, double *y, int incy, Session &session, int chunk = 0,
+                         double *elapsed = nullptr);
+
+/**
+ * Batched calls pack all vectors into one buffer, upload it once, run a single NDRange and download results once.
+ * Elapsed time includes transfers. The strided-batch layout has vector i at x + i * stridex and y + i * stridey.
+ */
+void saxpy_ocl_batched(const AxpyBatchItem<float> *items, int count, Session &session, double *elapsed = nullptr);
+void daxpy_ocl_batched(const AxpyBatchItem<double> *items, int count, Session &session, double *elapsed = nullptr);
+void saxpy_ocl_batched(int n, const float *a, float *x, int incx, int stridex, float *y, int incy, int stridey,
+                       int batch, Session &session, double *elapsed = nullptr);
+void daxpy_ocl_batched(int n, const double *a, double *x, int incx, int stridex, double *y, int incy, int stridey,
+                       int batch, Session &session, double *elapsed = nullptr);
+
 void saxpy_omp(int n, float a, float *x, int incx, float *y, int incy);
 void daxpy_omp(int n, double a, double *x, int incx, double *y, int incy);
+
+void saxpy_batched_omp(const AxpyBatchItem<float> *items, int count);
+void daxpy_batched_omp(const AxpyBatchItem<double> *items, int count);
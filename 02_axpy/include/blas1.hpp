@@ -0,0 +1,37 @@
+#pragma once
+
+#include <CL/cl.h>
+
+#include "deviceVector.hpp"
+
+/**
+ * BLAS level-1 routines. Host versions use OpenMP SIMD, device versions work on resident vectors.
+ * Device reductions either return the scalar or leave it in result[0], so it can stay on the device.
+ * Indices returned by isamax are 0-based.
+ */
+
+float sdot_omp(int n, const float *x, int incx, const float *y, int incy);
+double ddot_omp(int n, const double *x, int incx, const double *y, int incy);
+float snrm2_omp(int n, const float *x, int incx);
+float sasum_omp(int n, const float *x, int incx);
+void sscal_omp(int n, float a, float *x, int incx);
+void saxpby_omp(int n, float a, const float *x, int incx, float b, float *y, int incy);
+int isamax_omp(int n, const float *x, int incx);
+
+float sdot_ocl(int n, const DeviceVector<float> &x, int incx, const DeviceVector<float> &y, int incy,
+               double *elapsed = nullptr);
+void sdot_ocl(int n, const DeviceVector<float> &x, int incx, const DeviceVector<float> &y, int incy,
+              DeviceVector<float> &result, double *elapsed = nullptr);
+double ddot_ocl(int n, const DeviceVector<double> &x, int incx, const DeviceVector<double> &y, int incy,
+                double *elapsed = nullptr);
+void ddot_ocl(int n, const DeviceVector<double> &x, int incx, const DeviceVector<double> &y, int incy,
+              DeviceVector<double> &result, double *elapsed = nullptr);
+float snrm2_ocl(int n, const DeviceVector<float> &x, int incx, double *elapsed = nullptr);
+void snrm2_ocl(int n, const DeviceVector<float> &x, int incx, DeviceVector<float> &result, double *elapsed = nullptr);
+float sasum_ocl(int n, const DeviceVector<float> &x, int incx, double *elapsed = nullptr);
+void sasum_ocl(int n, const DeviceVector<float> &x, int incx, DeviceVector<float> &result, double *elapsed = nullptr);
+int isamax_ocl(int n, const DeviceVector<float> &x, int incx, double *elapsed = nullptr);
+void isamax_ocl(int n, const DeviceVector<float> &x, int incx, DeviceVector<int> &result, double *elapsed = nullptr);
+void sscal_ocl(int n, float a, DeviceVector<float> &x, int incx, double *elapsed = nullptr);
+void saxpby_ocl(int n, float a, const DeviceVector<float> &x, int incx, float b, DeviceVector<float> &y, int incy,
+                double *elapsed = nullptr);
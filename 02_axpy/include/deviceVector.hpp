@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+
+#include <CL/cl.h>
+
+#include "session.hpp"
+
+/**
+ * DeviceVector is a buffer which stays resident on the session device between calls.
+ * Data moves only on explicit upload and download, so chained operations skip host round trips.
+ */
+template <typename T>
+class DeviceVector {
+  public:
+    DeviceVector(Session &session, size_t size) : owner(session), count(size) {
+        mem = clCreateBuffer(owner.context(), CL_MEM_READ_WRITE, count * sizeof(T), nullptr, nullptr);
+    }
+    DeviceVector(Session &session, const T *data, size_t size) : DeviceVector(session, size) {
+        upload(data);
+    }
+    // With zeroCopy the buffer uses host memory directly; upload and download of that memory only map and unmap it
+    DeviceVector(Session &session, T *data, size_t size, bool zeroCopy) : owner(session), count(size) {
+        if (!zeroCopy) {
+            mem = clCreateBuffer(owner.context(), CL_MEM_READ_WRITE, count * sizeof(T), nullptr, nullptr);
+            upload(data);
+            return;
+        }
+        hostPtr = data;
+        mem = clCreateBuffer(owner.context(), CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, count * sizeof(T), hostPtr,
+                             nullptr);
+    }
+    DeviceVector(const DeviceVector &) = delete;
+    DeviceVector &operator=(const DeviceVector &) = delete;
+    ~DeviceVector() {
+        clReleaseMemObject(mem);
+    }
+
+    void upload(const T *data) {
+        if (data == hostPtr && hostPtr != nullptr)
+            sync(CL_MAP_WRITE);
+        else
+            clEnqueueWriteBuffer(owner.queue(), mem, CL_TRUE, 0, count * sizeof(T), data, 0, nullptr, nullptr);
+    }
+    void download(T *data) const {
+        if (data == hostPtr && hostPtr != nullptr)
+            sync(CL_MAP_READ);
+        else
+            clEnqueueReadBuffer(owner.queue(), mem, CL_TRUE, 0, count * sizeof(T), data, 0, nullptr, nullptr);
+    }
+
+    Session &session() const {
+        return owner;
+    }
+    cl_mem buffer() const {
+        return mem;
+    }
+    size_t size() const {
+        return count;
+    }
+
+  private:
+    void sync(cl_map_flags flags) const {
+        void *mapped = clEnqueueMapBuffer(owner.queue(), mem, CL_TRUE, flags, 0, count * sizeof(T), 0, nullptr,
+                                          nullptr, nullptr);
+        clEnqueueUnmapMemObject(owner.queue(), mem, mapped, 0, nullptr, nullptr);
+        clFinish(owner.queue());
+    }
+
+    Session &owner;
+    size_t count;
+    cl_mem mem;
+    T *hostPtr = nullptr;
+};
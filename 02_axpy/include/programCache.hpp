@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+
+#include <CL/cl.h>
+
+/**
+ * On-disk cache of compiled program binaries (CL_PROGRAM_BINARIES) stored in CACHE_DIR.
+ * Cache key is built from device name, driver version, build options and kernel source hash,
+ * so any of them changing leads to a rebuild from source.
+ */
+namespace ProgramCache {
+
+struct Stats {
+    int hits = 0;
+    int misses = 0;
+    double buildTime = 0;
+};
+
+cl_program build(cl_context context, cl_device_id deviceId, const std::string &file, const std::string &options = "");
+
+const Stats &stats();
+
+} // namespace ProgramCache
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <CL/cl.h>
+
+/**
+ * Session owns OpenCL context, command queue, built programs and kernels for a single device.
+ * Create it once and pass to every *_ocl call so that per-call cost is only transfers and kernel execution.
+ */
+class Session {
+  public:
+    explicit Session(cl_device_id deviceId);
+    Session(const Session &) = delete;
+    Session &operator=(const Session &) = delete;
+    ~Session();
+
+    cl_device_id device() const;
+    cl_context context() const;
+    // Queues with index > 0 are created on first use, e.g. for pipelining on several in-order queues
+    cl_command_queue queue(size_t index = 0);
+
+    // Zero-copy mode wraps host memory (CL_MEM_USE_HOST_PTR) instead of copying it, enabled on unified memory devices
+    bool unifiedMemory() const;
+    bool zeroCopy() const;
+    void setZeroCopy(bool enabled);
+
+    cl_kernel kernel(const std::string &file, const std::string &name, const std::string &options = "");
+
+  private:
+    cl_program program(const std::string &file, const std::string &options);
+
+    cl_device_id deviceId;
+    cl_context ctx;
+    std::vector<cl_command_queue> queues;
+    bool unified;
+    bool useHostPtr;
+    std::map<std::string, cl_program> programs;
+    std::map<std::string, cl_kernel> kernels;
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+/**
+ * Hand-vectorized host axpy kernels. The widest instruction set supported by the running CPU
+ * (AVX-512, AVX2+FMA, SSE2) is detected once on first use, so one binary runs on older and newer nodes.
+ * Unit strides use plain vector loads and stores, other positive strides use gather (and scatter where available).
+ */
+namespace Simd {
+
+using SaxpyKernel = void (*)(int n, float a, const float *x, int incx, float *y, int incy);
+using DaxpyKernel = void (*)(int n, double a, const double *x, int incx, double *y, int incy);
+
+SaxpyKernel saxpyKernel();
+DaxpyKernel daxpyKernel();
+
+const char *isaName();
+
+} // namespace Simd
@@ -2,22 +2,71 @@
 
 #include <algorithm>
 #include <iostream>
+#include <new>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace Utils {
 
 std::string readFile(const std::string &path);
 
+/**
+ * Allocator returning page-aligned storage, which OpenCL runtimes can use in place with CL_MEM_USE_HOST_PTR.
+ * Default-inserted elements are left uninitialized so that big buffers are first touched by the code filling them.
+ */
+template <typename T, size_t Alignment = 4096>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) {
+    }
+
+    T *allocate(size_t n) {
+        size_t size = (n * sizeof(T) + Alignment - 1) / Alignment * Alignment;
+        return static_cast<T *>(::operator new(size, std::align_val_t(Alignment)));
+    }
+    void deallocate(T *p, size_t) {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    void construct(U *) {
+    }
+    template <typename U, typename... Args>
+    void construct(U *p, Args &&...args) {
+        ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment> &) const {
+        return true;
+    }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment> &) const {
+        return false;
+    }
+};
+
 template <typename T>
-void print(const std::vector<T> &arr) {
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+template <typename T, typename Alloc>
+void print(const std::vector<T, Alloc> &arr) {
     for (const T &elem : arr)
         std::cout << elem << ' ';
     std::cout << std::endl;
 }
 
-template <typename T>
-void fillWithStride(std::vector<T> &arr, const T &value, size_t stride) {
+template <typename T, typename Alloc>
+void fillWithStride(std::vector<T, Alloc> &arr, const T &value, size_t stride) {
     size_t size = arr.size();
     for (size_t i = 0; i < size; i += stride)
         arr[i] = value;
@@ -25,4 +74,7 @@ void fillWithStride(std::vector<T> &arr, const T &value, size_t stride) {
 
 std::string status(bool ok);
 
+// Host memory bandwidth in GB/s measured with STREAM triad on all OpenMP threads
+double streamBandwidth();
+
 } // namespace Utils
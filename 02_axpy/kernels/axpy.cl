@@ -1,9 +1,88 @@
+#define CAT_(A, B) A##B
+#define CAT(A, B) CAT_(A, B)
+
 __kernel void saxpy(int n, float a, __global float *x, int incx, __global float *y, int incy) {
     int gid = get_global_id(0);
-    y[gid * incy] += a * x[gid * incx];
+    if (gid < n)
+        y[gid * incy] += a * x[gid * incx];
 }
 
 __kernel void daxpy(int n, double a, __global double *x, int incx, __global double *y, int incy) {
     int gid = get_global_id(0);
-    y[gid * incy] += a * x[gid * incx];
+    if (gid < n)
+        y[gid * incy] += a * x[gid * incx];
+}
+
+/**
+ * Kernels saxpyVector and daxpyVector work for unit strides only, each work-item processes FLOAT_WIDTH
+ * (DOUBLE_WIDTH) elements with vloadN/vstoreN and the work-item at the end of the vector processes the tail
+ */
+
+#ifdef FLOAT_WIDTH
+__kernel void saxpyVector(int n, float a, __global const float *x, __global float *y) {
+    int gid = get_global_id(0);
+    int i = gid * FLOAT_WIDTH;
+    if (i + FLOAT_WIDTH <= n) {
+        CAT(float, FLOAT_WIDTH) xv = CAT(vload, FLOAT_WIDTH)(gid, x);
+        CAT(float, FLOAT_WIDTH) yv = CAT(vload, FLOAT_WIDTH)(gid, y);
+        CAT(vstore, FLOAT_WIDTH)(yv + a * xv, gid, y);
+    } else {
+        for (; i < n; i++)
+            y[i] += a * x[i];
+    }
+}
+#endif
+
+#ifdef DOUBLE_WIDTH
+__kernel void daxpyVector(int n, double a, __global const double *x, __global double *y) {
+    int gid = get_global_id(0);
+    int i = gid * DOUBLE_WIDTH;
+    if (i + DOUBLE_WIDTH <= n) {
+        CAT(double, DOUBLE_WIDTH) xv = CAT(vload, DOUBLE_WIDTH)(gid, x);
+        CAT(double, DOUBLE_WIDTH) yv = CAT(vload, DOUBLE_WIDTH)(gid, y);
+        CAT(vstore, DOUBLE_WIDTH)(yv + a * xv, gid, y);
+    } else {
+        for (; i < n; i++)
+            y[i] += a * x[i];
+    }
+}
+#endif
+
+/**
+ * Batched kernels process many vectors packed one after another with unit strides, offsets[i] is the first element
+ * of vector i and offsets[count] is the total length, each work-item looks up its vector with binary search
+ */
+
+__kernel void saxpyBatched(int count, __global const int *offsets, __global const float *a, __global const float *x,
+                           __global float *y) {
+    int gid = get_global_id(0);
+    if (gid >= offsets[count])
+        return;
+    int lo = 0;
+    int hi = count;
+    while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
+        if (offsets[mid] <= gid)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    y[gid] += a[lo] * x[gid];
+}
+
+__kernel void daxpyBatched(int count, __global const int *offsets, __global const double *a, __global const double *x,
+                           __global double *y) {
+    int gid = get_global_id(0);
+    if (gid >= offsets[count])
+        return;
+    int lo = 0;
+    int hi = count;
+    while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
+        if (offsets[mid] <= gid)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    y[gid] += a[lo] * x[gid];
 }
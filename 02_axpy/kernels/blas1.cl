@@ -0,0 +1,128 @@
+#ifndef REAL
+#define REAL float
+#endif
+
+/**
+ * Reductions run in two passes: each work-group of the partial kernel reduces its grid-strided elements
+ * with a tree in local memory and writes one value, then a single work-group of the final kernel reduces
+ * those values into the result buffer. Local size has to be a power of two.
+ */
+
+// Tree reduction of scratch, the sum ends up in scratch[0]
+void groupSum(__local REAL *scratch) {
+    int lid = get_local_id(0);
+    for (int s = get_local_size(0) / 2; s > 0; s /= 2) {
+        barrier(CLK_LOCAL_MEM_FENCE);
+        if (lid < s)
+            scratch[lid] += scratch[lid + s];
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+}
+
+// Tree reduction keeping the largest value and the smallest index among equal values
+void groupMax(__local REAL *value, __local int *index) {
+    int lid = get_local_id(0);
+    for (int s = get_local_size(0) / 2; s > 0; s /= 2) {
+        barrier(CLK_LOCAL_MEM_FENCE);
+        if (lid < s) {
+            REAL other = value[lid + s];
+            if (other > value[lid] || (other == value[lid] && index[lid + s] < index[lid])) {
+                value[lid] = other;
+                index[lid] = index[lid + s];
+            }
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+}
+
+__kernel void dotPartial(int n, __global const REAL *x, int incx, __global const REAL *y, int incy,
+                         __global REAL *partial, __local REAL *scratch) {
+    REAL sum = 0;
+    for (int i = get_global_id(0); i < n; i += get_global_size(0))
+        sum += x[i * incx] * y[i * incy];
+    scratch[get_local_id(0)] = sum;
+    groupSum(scratch);
+    if (get_local_id(0) == 0)
+        partial[get_group_id(0)] = scratch[0];
+}
+
+__kernel void sumsqPartial(int n, __global const REAL *x, int incx, __global REAL *partial, __local REAL *scratch) {
+    REAL sum = 0;
+    for (int i = get_global_id(0); i < n; i += get_global_size(0))
+        sum += x[i * incx] * x[i * incx];
+    scratch[get_local_id(0)] = sum;
+    groupSum(scratch);
+    if (get_local_id(0) == 0)
+        partial[get_group_id(0)] = scratch[0];
+}
+
+__kernel void asumPartial(int n, __global const REAL *x, int incx, __global REAL *partial, __local REAL *scratch) {
+    REAL sum = 0;
+    for (int i = get_global_id(0); i < n; i += get_global_size(0))
+        sum += fabs(x[i * incx]);
+    scratch[get_local_id(0)] = sum;
+    groupSum(scratch);
+    if (get_local_id(0) == 0)
+        partial[get_group_id(0)] = scratch[0];
+}
+
+// With root != 0 the square root of the sum is stored (nrm2)
+__kernel void sumFinal(int count, __global const REAL *partial, int root, __global REAL *result,
+                       __local REAL *scratch) {
+    REAL sum = 0;
+    for (int i = get_local_id(0); i < count; i += get_local_size(0))
+        sum += partial[i];
+    scratch[get_local_id(0)] = sum;
+    groupSum(scratch);
+    if (get_local_id(0) == 0)
+        result[0] = root ? sqrt(scratch[0]) : scratch[0];
+}
+
+__kernel void iamaxPartial(int n, __global const REAL *x, int incx, __global REAL *partialValue,
+                           __global int *partialIndex, __local REAL *value, __local int *index) {
+    REAL best = -1;
+    int bestIndex = n;
+    for (int i = get_global_id(0); i < n; i += get_global_size(0)) {
+        REAL v = fabs(x[i * incx]);
+        if (v > best) {
+            best = v;
+            bestIndex = i;
+        }
+    }
+    value[get_local_id(0)] = best;
+    index[get_local_id(0)] = bestIndex;
+    groupMax(value, index);
+    if (get_local_id(0) == 0) {
+        partialValue[get_group_id(0)] = value[0];
+        partialIndex[get_group_id(0)] = index[0];
+    }
+}
+
+__kernel void iamaxFinal(int count, __global const REAL *partialValue, __global const int *partialIndex,
+                         __global int *result, __local REAL *value, __local int *index) {
+    REAL best = -1;
+    int bestIndex = INT_MAX;
+    for (int i = get_local_id(0); i < count; i += get_local_size(0)) {
+        if (partialValue[i] > best || (partialValue[i] == best && partialIndex[i] < bestIndex)) {
+            best = partialValue[i];
+            bestIndex = partialIndex[i];
+        }
+    }
+    value[get_local_id(0)] = best;
+    index[get_local_id(0)] = bestIndex;
+    groupMax(value, index);
+    if (get_local_id(0) == 0)
+        result[0] = index[0];
+}
+
+__kernel void scal(int n, REAL a, __global REAL *x, int incx) {
+    int gid = get_global_id(0);
+    if (gid < n)
+        x[gid * incx] *= a;
+}
+
+__kernel void axpby(int n, REAL a, __global const REAL *x, int incx, REAL b, __global REAL *y, int incy) {
+    int gid = get_global_id(0);
+    if (gid < n)
+        y[gid * incy] = a * x[gid * incx] + b * y[gid * incy];
+}
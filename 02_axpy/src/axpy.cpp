@@ -1,11 +1,17 @@
 #include "axpy.hpp"
 
+#include <algorithm>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 #include <omp.h>
 
+#include "simd.hpp"
 #include "utils.hpp"
 
+#define SAFE(X) (static_cast<size_t>(X))
+
 #define AXPY_IMPL                                                                                                      \
     for (int i = 0; i < n; i++)                                                                                        \
         y[i * incy] += a * x[i * incx];
@@ -18,108 +24,382 @@ void daxpy(int n, double a, double *x, int incx, double *y, int incy) {
     AXPY_IMPL
 }
 
-void saxpy_ocl(int n, float a, float *x, int incx, float *y, int incy, cl_device_id deviceId, double *elapsed) {
-    cl_context context = clCreateContext(nullptr, 1, &deviceId, nullptr, nullptr, nullptr);
-    cl_command_queue queue = clCreateCommandQueue(context, deviceId, 0, nullptr);
+void saxpy_simd(int n, float a, float *x, int incx, float *y, int incy) {
+    Simd::saxpyKernel()(n, a, x, incx, y, incy);
+}
 
-    cl_mem xMem = nullptr;
-    cl_mem yMem = nullptr;
+void daxpy_simd(int n, double a, double *x, int incx, double *y, int incy) {
+    Simd::daxpyKernel()(n, a, x, incx, y, incy);
+}
 
-    std::string source = Utils::readFile(KERNELS_DIR "axpy.cl");
-    const char *strings[] = {source.c_str()};
-    cl_program program = clCreateProgramWithSource(context, 1, strings, nullptr, nullptr);
-    clBuildProgram(program, 1, &deviceId, nullptr, nullptr, nullptr);
-    cl_kernel kernel = clCreateKernel(program, "saxpy", nullptr);
+static cl_uint vectorWidth(cl_device_id deviceId, cl_device_info param) {
+    cl_uint width = 0;
+    clGetDeviceInfo(deviceId, param, sizeof(cl_uint), &width, nullptr);
+    return width;
+}
 
-    xMem = clCreateBuffer(context, CL_MEM_READ_ONLY, n * incx * sizeof(float), nullptr, nullptr);
-    clEnqueueWriteBuffer(queue, xMem, CL_TRUE, 0, n * incx * sizeof(float), x, 0, nullptr, nullptr);
-    clSetKernelArg(kernel, 2, sizeof(cl_mem), &xMem);
+// Build options enabling vector kernels with the widths preferred by the device
+static std::string axpyOptions(cl_device_id deviceId) {
+    std::string options;
+    cl_uint floatWidth = vectorWidth(deviceId, CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT);
+    cl_uint doubleWidth = vectorWidth(deviceId, CL_DEVICE_PREFERRED_VECTOR_WIDTH_DOUBLE);
+    if (floatWidth > 1)
+        options += " -DFLOAT_WIDTH=" + std::to_string(floatWidth);
+    if (doubleWidth > 1)
+        options += " -DDOUBLE_WIDTH=" + std::to_string(doubleWidth);
+    return options;
+}
 
-    yMem = clCreateBuffer(context, CL_MEM_READ_WRITE, n * incy * sizeof(float), nullptr, nullptr);
-    clEnqueueWriteBuffer(queue, yMem, CL_TRUE, 0, n * incy * sizeof(float), y, 0, nullptr, nullptr);
-    clSetKernelArg(kernel, 4, sizeof(cl_mem), &yMem);
+// Enqueues axpy on buffers which are already on the device, does not wait for completion
+template <typename T>
+static void enqueueAxpy(const char *name, int n, T a, cl_mem xMem, int incx, cl_mem yMem, int incy, Session &session,
+                        cl_command_queue queue) {
+    cl_device_id deviceId = session.device();
+    cl_uint width = vectorWidth(deviceId, std::is_same<T, float>::value ? CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT
+                                                                        : CL_DEVICE_PREFERRED_VECTOR_WIDTH_DOUBLE);
+    bool vector = incx == 1 && incy == 1 && width > 1;
+    cl_kernel kernel = session.kernel("axpy.cl", vector ? std::string(name) + "Vector" : name, axpyOptions(deviceId));
 
-    clSetKernelArg(kernel, 0, sizeof(int), &n);
-    clSetKernelArg(kernel, 1, sizeof(float), &a);
-    clSetKernelArg(kernel, 3, sizeof(int), &incx);
-    clSetKernelArg(kernel, 5, sizeof(int), &incy);
+    if (vector) {
+        clSetKernelArg(kernel, 0, sizeof(int), &n);
+        clSetKernelArg(kernel, 1, sizeof(T), &a);
+        clSetKernelArg(kernel, 2, sizeof(cl_mem), &xMem);
+        clSetKernelArg(kernel, 3, sizeof(cl_mem), &yMem);
+    } else {
+        clSetKernelArg(kernel, 0, sizeof(int), &n);
+        clSetKernelArg(kernel, 1, sizeof(T), &a);
+        clSetKernelArg(kernel, 2, sizeof(cl_mem), &xMem);
+        clSetKernelArg(kernel, 3, sizeof(int), &incx);
+        clSetKernelArg(kernel, 4, sizeof(cl_mem), &yMem);
+        clSetKernelArg(kernel, 5, sizeof(int), &incy);
+    }
 
-    size_t group;
+    size_t group = 0;
     clGetKernelWorkGroupInfo(kernel, deviceId, CL_KERNEL_WORK_GROUP_SIZE, sizeof(size_t), &group, nullptr);
 
-    const size_t globalWorkSize = static_cast<size_t>(n);
-    const size_t localWorkSize = 256u;
-    double begin = omp_get_wtime();
+    // Global size is rounded up to the work-group size, kernels skip work-items past the end of the vector
+    const size_t items = vector ? (SAFE(n) + width - 1) / width : SAFE(n);
+    const size_t localWorkSize = std::min<size_t>(256u, std::max<size_t>(group, 1u));
+    const size_t globalWorkSize = (items + localWorkSize - 1) / localWorkSize * localWorkSize;
     clEnqueueNDRangeKernel(queue, kernel, 1, nullptr, &globalWorkSize, &localWorkSize, 0, nullptr, nullptr);
+}
+
+template <typename T>
+static void axpy_ocl(const char *name, int n, T a, const DeviceVector<T> &x, int incx, DeviceVector<T> &y, int incy,
+                     double *elapsed) {
+    if (n <= 0)
+        return;
+    Session &session = y.session();
+    cl_command_queue queue = session.queue();
+    double begin = omp_get_wtime();
+    enqueueAxpy(name, n, a, x.buffer(), incx, y.buffer(), incy, session, queue);
     clFinish(queue);
     double end = omp_get_wtime();
     if (elapsed != nullptr)
         *elapsed = end - begin;
-    clEnqueueReadBuffer(queue, yMem, CL_TRUE, 0, n * incy * sizeof(float), y, 0, nullptr, nullptr);
+}
 
-    clReleaseMemObject(xMem);
-    clReleaseMemObject(yMem);
-    clReleaseKernel(kernel);
-    clReleaseProgram(program);
+template <typename T>
+static void pack(int n, const T *src, int inc, T *dst) {
+#pragma omp parallel for
+    for (int i = 0; i < n; i++)
+        dst[i] = src[i * inc];
+}
 
-    clReleaseCommandQueue(queue);
-    clReleaseContext(context);
+template <typename T>
+static void unpack(int n, const T *src, T *dst, int inc) {
+#pragma omp parallel for
+    for (int i = 0; i < n; i++)
+        dst[i * inc] = src[i];
 }
 
-void daxpy_ocl(int n, double a, double *x, int incx, double *y, int incy, cl_device_id deviceId, double *elapsed) {
-    cl_context context = clCreateContext(nullptr, 1, &deviceId, nullptr, nullptr, nullptr);
-    cl_command_queue queue = clCreateCommandQueue(context, deviceId, 0, nullptr);
+template <typename T>
+static void axpy_ocl(const char *name, int n, T a, T *x, int incx, T *y, int incy, Session &session, double *elapsed,
+                     TransferStats *transfer) {
+    // Strided vectors are packed into contiguous storage so that the device gets only the elements it uses
+    Utils::AlignedVector<T> xPacked(incx > 1 ? n : 0);
+    Utils::AlignedVector<T> yPacked(incy > 1 ? n : 0);
+    if (!xPacked.empty())
+        pack(n, x, incx, xPacked.data());
+    if (!yPacked.empty())
+        pack(n, y, incy, yPacked.data());
 
-    cl_mem xMem = nullptr;
-    cl_mem yMem = nullptr;
+    T *xHost = xPacked.empty() ? x : xPacked.data();
+    T *yHost = yPacked.empty() ? y : yPacked.data();
+    size_t xSize = xPacked.empty() ? SAFE(n) * incx : SAFE(n);
+    size_t ySize = yPacked.empty() ? SAFE(n) * incy : SAFE(n);
+    DeviceVector<T> xDev(session, xHost, xSize, session.zeroCopy());
+    DeviceVector<T> yDev(session, yHost, ySize, session.zeroCopy());
+    axpy_ocl(name, n, a, xDev, xPacked.empty() ? incx : 1, yDev, yPacked.empty() ? incy : 1, elapsed);
+    yDev.download(yHost);
 
-    std::string source = Utils::readFile(KERNELS_DIR "axpy.cl");
-    const char *strings[] = {source.c_str()};
-    cl_program program = clCreateProgramWithSource(context, 1, strings, nullptr, nullptr);
-    clBuildProgram(program, 1, &deviceId, nullptr, nullptr, nullptr);
-    cl_kernel kernel = clCreateKernel(program, "daxpy", nullptr);
+    if (!yPacked.empty())
+        unpack(n, yPacked.data(), y, incy);
+    if (transfer != nullptr) {
+        transfer->bytes = session.zeroCopy() ? 0 : (xSize + 2 * ySize) * sizeof(T);
+        transfer->bytesSaved = (SAFE(n) * incx + 2 * SAFE(n) * incy) * sizeof(T) - transfer->bytes;
+    }
+}
 
-    xMem = clCreateBuffer(context, CL_MEM_READ_ONLY, n * incx * sizeof(double), nullptr, nullptr);
-    clEnqueueWriteBuffer(queue, xMem, CL_TRUE, 0, n * incx * sizeof(double), x, 0, nullptr, nullptr);
-    clSetKernelArg(kernel, 2, sizeof(cl_mem), &xMem);
+// Chunk size keeps all pipeline slots within a quarter of device memory and the vectors split in several chunks
+template <typename T>
+static int pipelineChunk(int n, int slots, cl_device_id deviceId) {
+    cl_ulong globalMemSize = 0;
+    cl_ulong maxAllocSize = 0;
+    clGetDeviceInfo(deviceId, CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(cl_ulong), &globalMemSize, nullptr);
+    clGetDeviceInfo(deviceId, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(cl_ulong), &maxAllocSize, nullptr);
+    size_t chunk = std::max<size_t>(1u << 20, (SAFE(n) + 15) / 16);
+    chunk = std::min<size_t>(chunk, globalMemSize / 4 / (2 * slots * sizeof(T)));
+    chunk = std::min<size_t>(chunk, maxAllocSize / sizeof(T));
+    return static_cast<int>(std::max<size_t>(std::min<size_t>(chunk, SAFE(n)), 1u));
+}
 
-    yMem = clCreateBuffer(context, CL_MEM_READ_WRITE, n * incy * sizeof(double), nullptr, nullptr);
-    clEnqueueWriteBuffer(queue, yMem, CL_TRUE, 0, n * incy * sizeof(double), y, 0, nullptr, nullptr);
-    clSetKernelArg(kernel, 4, sizeof(cl_mem), &yMem);
+/**
+ * Vectors are processed in chunks, chunk i uses pipeline slot i % slots with its own queue and buffers,
+ * so upload of one chunk, computation of another and download of the third run at the same time.
+ * Strided chunks are packed on the host while the device works on the previous ones.
+ */
+template <typename T>
+static void axpy_ocl_pipelined(const char *name, int n, T a, T *x, int incx, T *y, int incy, Session &session,
+                               int chunk, double *elapsed) {
+    if (n <= 0)
+        return;
+    constexpr int slots = 3;
+    if (chunk <= 0)
+        chunk = pipelineChunk<T>(n, slots, session.device());
+    double begin = omp_get_wtime();
 
-    clSetKernelArg(kernel, 0, sizeof(int), &n);
-    clSetKernelArg(kernel, 1, sizeof(double), &a);
-    clSetKernelArg(kernel, 3, sizeof(int), &incx);
-    clSetKernelArg(kernel, 5, sizeof(int), &incy);
+    cl_mem xMem[slots], yMem[slots];
+    cl_event done[slots] = {nullptr};
+    int pendingBegin[slots] = {0};
+    int pendingCount[slots] = {0};
+    Utils::AlignedVector<T> xStage[slots], yStage[slots];
+    for (int s = 0; s < slots; s++) {
+        xMem[s] = clCreateBuffer(session.context(), CL_MEM_READ_ONLY, SAFE(chunk) * sizeof(T), nullptr, nullptr);
+        yMem[s] = clCreateBuffer(session.context(), CL_MEM_READ_WRITE, SAFE(chunk) * sizeof(T), nullptr, nullptr);
+        if (incx != 1)
+            xStage[s].resize(chunk);
+        if (incy != 1)
+            yStage[s].resize(chunk);
+    }
 
-    size_t group;
-    clGetKernelWorkGroupInfo(kernel, deviceId, CL_KERNEL_WORK_GROUP_SIZE, sizeof(size_t), &group, nullptr);
+    auto finish = [&](int s) {
+        if (done[s] == nullptr)
+            return;
+        clWaitForEvents(1, &done[s]);
+        clReleaseEvent(done[s]);
+        done[s] = nullptr;
+        if (incy != 1)
+            unpack(pendingCount[s], yStage[s].data(), y + SAFE(pendingBegin[s]) * incy, incy);
+    };
+
+    for (int first = 0, c = 0; first < n; first += chunk, c++) {
+        int s = c % slots;
+        int count = std::min(chunk, n - first);
+        finish(s);
+
+        T *xHost = x + SAFE(first) * incx;
+        T *yHost = y + SAFE(first) * incy;
+        if (incx != 1) {
+            pack(count, xHost, incx, xStage[s].data());
+            xHost = xStage[s].data();
+        }
+        if (incy != 1) {
+            pack(count, yHost, incy, yStage[s].data());
+            yHost = yStage[s].data();
+        }
+
+        cl_command_queue queue = session.queue(s);
+        size_t bytes = SAFE(count) * sizeof(T);
+        clEnqueueWriteBuffer(queue, xMem[s], CL_FALSE, 0, bytes, xHost, 0, nullptr, nullptr);
+        clEnqueueWriteBuffer(queue, yMem[s], CL_FALSE, 0, bytes, yHost, 0, nullptr, nullptr);
+        enqueueAxpy(name, count, a, xMem[s], 1, yMem[s], 1, session, queue);
+        clEnqueueReadBuffer(queue, yMem[s], CL_FALSE, 0, bytes, yHost, 0, nullptr, &done[s]);
+        clFlush(queue);
+        pendingBegin[s] = first;
+        pendingCount[s] = count;
+    }
+    for (int s = 0; s < slots; s++) {
+        finish(s);
+        clReleaseMemObject(xMem[s]);
+        clReleaseMemObject(yMem[s]);
+    }
 
-    const size_t globalWorkSize = static_cast<size_t>(n);
-    const size_t localWorkSize = 256u;
-    double begin = omp_get_wtime();
-    clEnqueueNDRangeKernel(queue, kernel, 1, nullptr, &globalWorkSize, &localWorkSize, 0, nullptr, nullptr);
-    clFinish(queue);
     double end = omp_get_wtime();
     if (elapsed != nullptr)
         *elapsed = end - begin;
-    clEnqueueReadBuffer(queue, yMem, CL_TRUE, 0, n * incy * sizeof(double), y, 0, nullptr, nullptr);
+}
+
+template <typename T>
+static void axpy_ocl_batched(const char *name, const AxpyBatchItem<T> *items, int count, Session &session,
+                             double *elapsed) {
+    std::vector<int> offsets(SAFE(count) + 1, 0);
+    std::vector<T> coefs(SAFE(count));
+    for (int i = 0; i < count; i++) {
+        offsets[i + 1] = offsets[i] + std::max(items[i].n, 0);
+        coefs[i] = items[i].a;
+    }
+    int total = offsets[count];
+    if (total == 0)
+        return;
 
+    Utils::AlignedVector<T> xPacked(total);
+    Utils::AlignedVector<T> yPacked(total);
+#pragma omp parallel for schedule(dynamic, 16)
+    for (int i = 0; i < count; i++) {
+        const AxpyBatchItem<T> &item = items[i];
+        for (int j = 0; j < item.n; j++) {
+            xPacked[offsets[i] + j] = item.x[SAFE(j) * item.incx];
+            yPacked[offsets[i] + j] = item.y[SAFE(j) * item.incy];
+        }
+    }
+
+    double begin = omp_get_wtime();
+    cl_context context = session.context();
+    cl_command_queue queue = session.queue();
+    cl_mem offsetsMem = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, offsets.size() * sizeof(int),
+                                       offsets.data(), nullptr);
+    cl_mem aMem = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, coefs.size() * sizeof(T),
+                                 coefs.data(), nullptr);
+    cl_mem xMem = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, SAFE(total) * sizeof(T),
+                                 xPacked.data(), nullptr);
+    cl_mem yMem = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, SAFE(total) * sizeof(T),
+                                 yPacked.data(), nullptr);
+
+    cl_kernel kernel = session.kernel("axpy.cl", std::string(name) + "Batched", axpyOptions(session.device()));
+    clSetKernelArg(kernel, 0, sizeof(int), &count);
+    clSetKernelArg(kernel, 1, sizeof(cl_mem), &offsetsMem);
+    clSetKernelArg(kernel, 2, sizeof(cl_mem), &aMem);
+    clSetKernelArg(kernel, 3, sizeof(cl_mem), &xMem);
+    clSetKernelArg(kernel, 4, sizeof(cl_mem), &yMem);
+
+    size_t group = 0;
+    clGetKernelWorkGroupInfo(kernel, session.device(), CL_KERNEL_WORK_GROUP_SIZE, sizeof(size_t), &group, nullptr);
+    const size_t localWorkSize = std::min<size_t>(256u, std::max<size_t>(group, 1u));
+    const size_t globalWorkSize = (SAFE(total) + localWorkSize - 1) / localWorkSize * localWorkSize;
+    clEnqueueNDRangeKernel(queue, kernel, 1, nullptr, &globalWorkSize, &localWorkSize, 0, nullptr, nullptr);
+    clEnqueueReadBuffer(queue, yMem, CL_TRUE, 0, SAFE(total) * sizeof(T), yPacked.data(), 0, nullptr, nullptr);
+    double end = omp_get_wtime();
+
+    clReleaseMemObject(offsetsMem);
+    clReleaseMemObject(aMem);
     clReleaseMemObject(xMem);
     clReleaseMemObject(yMem);
-    clReleaseKernel(kernel);
-    clReleaseProgram(program);
 
-    clReleaseCommandQueue(queue);
-    clReleaseContext(context);
+#pragma omp parallel for schedule(dynamic, 16)
+    for (int i = 0; i < count; i++) {
+        const AxpyBatchItem<T> &item = items[i];
+        for (int j = 0; j < item.n; j++)
+            item.y[SAFE(j) * item.incy] = yPacked[offsets[i] + j];
+    }
+    if (elapsed != nullptr)
+        *elapsed = end - begin;
+}
+
+template <typename T>
+static std::vector<AxpyBatchItem<T>> stridedBatch(int n, const T *a, T *x, int incx, int stridex, T *y, int incy,
+                                                  int stridey, int batch) {
+    std::vector<AxpyBatchItem<T>> items(SAFE(batch));
+    for (int i = 0; i < batch; i++)
+        items[i] = {n, a[i], x + SAFE(i) * stridex, incx, y + SAFE(i) * stridey, incy};
+    return items;
+}
+
+void saxpy_ocl(int n, float a, float *x, int incx, float *y, int incy, cl_device_id deviceId, double *elapsed) {
+    Session session(deviceId);
+    axpy_ocl("saxpy", n, a, x, incx, y, incy, session, elapsed, nullptr);
+}
+
+void daxpy_ocl(int n, double a, double *x, int incx, double *y, int incy, cl_device_id deviceId, double *elapsed) {
+    Session session(deviceId);
+    axpy_ocl("daxpy", n, a, x, incx, y, incy, session, elapsed, nullptr);
+}
+
+void saxpy_ocl(int n, float a, float *x, int incx, float *y, int incy, Session &session, double *elapsed,
+               TransferStats *transfer) {
+    axpy_ocl("saxpy", n, a, x, incx, y, incy, session, elapsed, transfer);
+}
+
+void daxpy_ocl(int n, double a, double *x, int incx, double *y, int incy, Session &session, double *elapsed,
+               TransferStats *transfer) {
+    axpy_ocl("daxpy", n, a, x, incx, y, incy, session, elapsed, transfer);
+}
+
+void saxpy_ocl(int n, float a, const DeviceVector<float> &x, int incx, DeviceVector<float> &y, int incy,
+               double *elapsed) {
+    axpy_ocl("saxpy", n, a, x, incx, y, incy, elapsed);
+}
+
+void daxpy_ocl(int n, double a, const DeviceVector<double> &x, int incx, DeviceVector<double> &y, int incy,
+               double *elapsed) {
+    axpy_ocl("daxpy", n, a, x, incx, y, incy, elapsed);
+}
+
+void saxpy_ocl_pipelined(int n, float a, float *x, int incx, float *y, int incy, Session &session, int chunk,
+                         double *elapsed) {
+    axpy_ocl_pipelined("saxpy", n, a, x, incx, y, incy, session, chunk, elapsed);
+}
+
+void daxpy_ocl_pipelined(int n, double a, double *x, int incx, double *y, int incy, Session &session, int chunk,
+                         double *elapsed) {
+    axpy_ocl_pipelined("daxpy", n, a, x, incx, y, incy, session, chunk, elapsed);
+}
+
+void saxpy_ocl_batched(const AxpyBatchItem<float> *items, int count, Session &session, double *elapsed) {
+    axpy_ocl_batched("saxpy", items, count, session, elapsed);
+}
+
+void daxpy_ocl_batched(const AxpyBatchItem<double> *items, int count, Session &session, double *elapsed) {
+    axpy_ocl_batched("daxpy", items, count, session, elapsed);
+}
+
+void saxpy_ocl_batched(int n, const float *a, float *x, int incx, int stridex, float *y, int incy, int stridey,
+                       int batch, Session &session, double *elapsed) {
+    auto items = stridedBatch(n, a, x, incx, stridex, y, incy, stridey, batch);
+    axpy_ocl_batched("saxpy", items.data(), batch, session, elapsed);
+}
+
+void daxpy_ocl_batched(int n, const double *a, double *x, int incx, int stridex, double *y, int incy, int stridey,
+                       int batch, Session &session, double *elapsed) {
+    auto items = stridedBatch(n, a, x, incx, stridex, y, incy, stridey, batch);
+    axpy_ocl_batched("daxpy", items.data(), batch, session, elapsed);
+}
+
+// Each OpenMP thread runs the SIMD kernel on its own contiguous chunk of elements
+template <typename T, typename Kernel>
+static void axpy_omp(Kernel kernel, int n, T a, T *x, int incx, T *y, int incy) {
+#pragma omp parallel
+    {
+        int threads = omp_get_num_threads();
+        int chunk = (n + threads - 1) / threads;
+        int begin = std::min(n, chunk * omp_get_thread_num());
+        int end = std::min(n, begin + chunk);
+        if (begin < end)
+            kernel(end - begin, a, x + SAFE(begin) * incx, incx, y + SAFE(begin) * incy, incy);
+    }
 }
 
 void saxpy_omp(int n, float a, float *x, int incx, float *y, int incy) {
-#pragma omp parallel for
-    AXPY_IMPL
+    axpy_omp(Simd::saxpyKernel(), n, a, x, incx, y, incy);
 }
 
 void daxpy_omp(int n, double a, double *x, int incx, double *y, int incy) {
-#pragma omp parallel for
-    AXPY_IMPL
+    axpy_omp(Simd::daxpyKernel(), n, a, x, incx, y, incy);
+}
+
+// Vectors of a batch are small, so threads take whole vectors and each one runs the SIMD kernel
+template <typename T, typename Kernel>
+static void axpy_batched_omp(Kernel kernel, const AxpyBatchItem<T> *items, int count) {
+#pragma omp parallel for schedule(dynamic, 16)
+    for (int i = 0; i < count; i++)
+        if (items[i].n > 0)
+            kernel(items[i].n, items[i].a, items[i].x, items[i].incx, items[i].y, items[i].incy);
+}
+
+void saxpy_batched_omp(const AxpyBatchItem<float> *items, int count) {
+    axpy_batched_omp(Simd::saxpyKernel(), items, count);
+}
+
+void daxpy_batched_omp(const AxpyBatchItem<double> *items, int count) {
+    axpy_batched_omp(Simd::daxpyKernel(), items, count);
 }
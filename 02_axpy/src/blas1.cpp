@@ -0,0 +1,296 @@
+#include "blas1.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <type_traits>
+
+#include <omp.h>
+
+#define SAFE(X) (static_cast<size_t>(X))
+
+template <typename T>
+static T dot_omp(int n, const T *x, int incx, const T *y, int incy) {
+    T sum = 0;
+#pragma omp parallel for simd reduction(+ : sum)
+    for (int i = 0; i < n; i++)
+        sum += x[SAFE(i) * incx] * y[SAFE(i) * incy];
+    return sum;
+}
+
+float sdot_omp(int n, const float *x, int incx, const float *y, int incy) {
+    return dot_omp(n, x, incx, y, incy);
+}
+
+double ddot_omp(int n, const double *x, int incx, const double *y, int incy) {
+    return dot_omp(n, x, incx, y, incy);
+}
+
+float snrm2_omp(int n, const float *x, int incx) {
+    return std::sqrt(dot_omp(n, x, incx, x, incx));
+}
+
+float sasum_omp(int n, const float *x, int incx) {
+    float sum = 0;
+#pragma omp parallel for simd reduction(+ : sum)
+    for (int i = 0; i < n; i++)
+        sum += std::fabs(x[SAFE(i) * incx]);
+    return sum;
+}
+
+void sscal_omp(int n, float a, float *x, int incx) {
+#pragma omp parallel for simd
+    for (int i = 0; i < n; i++)
+        x[SAFE(i) * incx] *= a;
+}
+
+void saxpby_omp(int n, float a, const float *x, int incx, float b, float *y, int incy) {
+#pragma omp parallel for simd
+    for (int i = 0; i < n; i++)
+        y[SAFE(i) * incy] = a * x[SAFE(i) * incx] + b * y[SAFE(i) * incy];
+}
+
+int isamax_omp(int n, const float *x, int incx) {
+    float best = -1.f;
+    int bestIndex = n > 0 ? 0 : -1;
+#pragma omp parallel
+    {
+        // Each thread scans a contiguous range in order, so its first maximum has the smallest index
+        float threadBest = -1.f;
+        int threadIndex = n;
+#pragma omp for nowait
+        for (int i = 0; i < n; i++) {
+            float v = std::fabs(x[SAFE(i) * incx]);
+            if (v > threadBest) {
+                threadBest = v;
+                threadIndex = i;
+            }
+        }
+#pragma omp critical
+        if (threadBest > best || (threadBest == best && threadIndex < bestIndex)) {
+            best = threadBest;
+            bestIndex = threadIndex;
+        }
+    }
+    return bestIndex;
+}
+
+template <typename T>
+static std::string blasOptions() {
+    return std::is_same<T, double>::value ? "-DREAL=double" : "-DREAL=float";
+}
+
+// Largest power of two not exceeding 256 and the kernel work-group size, tree reductions rely on it
+static size_t reductionLocalSize(cl_kernel kernel, cl_device_id deviceId) {
+    size_t group = 0;
+    clGetKernelWorkGroupInfo(kernel, deviceId, CL_KERNEL_WORK_GROUP_SIZE, sizeof(size_t), &group, nullptr);
+    size_t local = 1;
+    while (local * 2 <= std::min<size_t>(group, 256u))
+        local *= 2;
+    return local;
+}
+
+// A few work-groups per compute unit are enough, every work-item accumulates grid-strided elements first
+static size_t reductionGroups(int n, size_t local, cl_device_id deviceId) {
+    cl_uint units = 1;
+    clGetDeviceInfo(deviceId, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), &units, nullptr);
+    return std::max<size_t>(1u, std::min<size_t>(4u * units, (SAFE(n) + local - 1) / local));
+}
+
+/**
+ * Sum of x*y (y given), x*x (square) or |x| is reduced into result[0], with root the square root is stored.
+ * Partial sums of work-groups stay on the device between the two passes.
+ */
+template <typename T>
+static void reduce_ocl(const char *name, int n, const DeviceVector<T> &x, int incx, const DeviceVector<T> *y, int incy,
+                       bool root, DeviceVector<T> &result, double *elapsed) {
+    Session &session = x.session();
+    cl_device_id deviceId = session.device();
+    cl_command_queue queue = session.queue();
+    cl_kernel partialKernel = session.kernel("blas1.cl", name, blasOptions<T>());
+    cl_kernel finalKernel = session.kernel("blas1.cl", "sumFinal", blasOptions<T>());
+    n = std::max(n, 0);
+
+    size_t local = reductionLocalSize(partialKernel, deviceId);
+    size_t groups = reductionGroups(n, local, deviceId);
+    cl_mem partial = clCreateBuffer(session.context(), CL_MEM_READ_WRITE, groups * sizeof(T), nullptr, nullptr);
+    cl_mem xMem = x.buffer();
+    cl_mem resultMem = result.buffer();
+
+    cl_uint arg = 0;
+    clSetKernelArg(partialKernel, arg++, sizeof(int), &n);
+    clSetKernelArg(partialKernel, arg++, sizeof(cl_mem), &xMem);
+    clSetKernelArg(partialKernel, arg++, sizeof(int), &incx);
+    if (y != nullptr) {
+        cl_mem yMem = y->buffer();
+        clSetKernelArg(partialKernel, arg++, sizeof(cl_mem), &yMem);
+        clSetKernelArg(partialKernel, arg++, sizeof(int), &incy);
+    }
+    clSetKernelArg(partialKernel, arg++, sizeof(cl_mem), &partial);
+    clSetKernelArg(partialKernel, arg++, local * sizeof(T), nullptr);
+
+    int count = static_cast<int>(groups);
+    int sqrtResult = root ? 1 : 0;
+    size_t finalLocal = reductionLocalSize(finalKernel, deviceId);
+    clSetKernelArg(finalKernel, 0, sizeof(int), &count);
+    clSetKernelArg(finalKernel, 1, sizeof(cl_mem), &partial);
+    clSetKernelArg(finalKernel, 2, sizeof(int), &sqrtResult);
+    clSetKernelArg(finalKernel, 3, sizeof(cl_mem), &resultMem);
+    clSetKernelArg(finalKernel, 4, finalLocal * sizeof(T), nullptr);
+
+    const size_t globalWorkSize = groups * local;
+    double begin = omp_get_wtime();
+    clEnqueueNDRangeKernel(queue, partialKernel, 1, nullptr, &globalWorkSize, &local, 0, nullptr, nullptr);
+    clEnqueueNDRangeKernel(queue, finalKernel, 1, nullptr, &finalLocal, &finalLocal, 0, nullptr, nullptr);
+    clFinish(queue);
+    double end = omp_get_wtime();
+    clReleaseMemObject(partial);
+    if (elapsed != nullptr)
+        *elapsed = end - begin;
+}
+
+template <typename T>
+static T reduce_ocl(const char *name, int n, const DeviceVector<T> &x, int incx, const DeviceVector<T> *y, int incy,
+                    bool root, double *elapsed) {
+    DeviceVector<T> result(x.session(), 1);
+    reduce_ocl(name, n, x, incx, y, incy, root, result, elapsed);
+    T value = 0;
+    result.download(&value);
+    return value;
+}
+
+float sdot_ocl(int n, const DeviceVector<float> &x, int incx, const DeviceVector<float> &y, int incy,
+               double *elapsed) {
+    return reduce_ocl("dotPartial", n, x, incx, &y, incy, false, elapsed);
+}
+
+void sdot_ocl(int n, const DeviceVector<float> &x, int incx, const DeviceVector<float> &y, int incy,
+              DeviceVector<float> &result, double *elapsed) {
+    reduce_ocl("dotPartial", n, x, incx, &y, incy, false, result, elapsed);
+}
+
+double ddot_ocl(int n, const DeviceVector<double> &x, int incx, const DeviceVector<double> &y, int incy,
+                double *elapsed) {
+    return reduce_ocl("dotPartial", n, x, incx, &y, incy, false, elapsed);
+}
+
+void ddot_ocl(int n, const DeviceVector<double> &x, int incx, const DeviceVector<double> &y, int incy,
+              DeviceVector<double> &result, double *elapsed) {
+    reduce_ocl("dotPartial", n, x, incx, &y, incy, false, result, elapsed);
+}
+
+float snrm2_ocl(int n, const DeviceVector<float> &x, int incx, double *elapsed) {
+    return reduce_ocl<float>("sumsqPartial", n, x, incx, nullptr, 0, true, elapsed);
+}
+
+void snrm2_ocl(int n, const DeviceVector<float> &x, int incx, DeviceVector<float> &result, double *elapsed) {
+    reduce_ocl<float>("sumsqPartial", n, x, incx, nullptr, 0, true, result, elapsed);
+}
+
+float sasum_ocl(int n, const DeviceVector<float> &x, int incx, double *elapsed) {
+    return reduce_ocl<float>("asumPartial", n, x, incx, nullptr, 0, false, elapsed);
+}
+
+void sasum_ocl(int n, const DeviceVector<float> &x, int incx, DeviceVector<float> &result, double *elapsed) {
+    reduce_ocl<float>("asumPartial", n, x, incx, nullptr, 0, false, result, elapsed);
+}
+
+void isamax_ocl(int n, const DeviceVector<float> &x, int incx, DeviceVector<int> &result, double *elapsed) {
+    Session &session = x.session();
+    cl_device_id deviceId = session.device();
+    cl_command_queue queue = session.queue();
+    cl_kernel partialKernel = session.kernel("blas1.cl", "iamaxPartial", blasOptions<float>());
+    cl_kernel finalKernel = session.kernel("blas1.cl", "iamaxFinal", blasOptions<float>());
+    n = std::max(n, 0);
+
+    size_t local = reductionLocalSize(partialKernel, deviceId);
+    size_t groups = reductionGroups(n, local, deviceId);
+    cl_context context = session.context();
+    cl_mem partialValue = clCreateBuffer(context, CL_MEM_READ_WRITE, groups * sizeof(float), nullptr, nullptr);
+    cl_mem partialIndex = clCreateBuffer(context, CL_MEM_READ_WRITE, groups * sizeof(int), nullptr, nullptr);
+    cl_mem xMem = x.buffer();
+    cl_mem resultMem = result.buffer();
+
+    clSetKernelArg(partialKernel, 0, sizeof(int), &n);
+    clSetKernelArg(partialKernel, 1, sizeof(cl_mem), &xMem);
+    clSetKernelArg(partialKernel, 2, sizeof(int), &incx);
+    clSetKernelArg(partialKernel, 3, sizeof(cl_mem), &partialValue);
+    clSetKernelArg(partialKernel, 4, sizeof(cl_mem), &partialIndex);
+    clSetKernelArg(partialKernel, 5, local * sizeof(float), nullptr);
+    clSetKernelArg(partialKernel, 6, local * sizeof(int), nullptr);
+
+    int count = static_cast<int>(groups);
+    size_t finalLocal = reductionLocalSize(finalKernel, deviceId);
+    clSetKernelArg(finalKernel, 0, sizeof(int), &count);
+    clSetKernelArg(finalKernel, 1, sizeof(cl_mem), &partialValue);
+    clSetKernelArg(finalKernel, 2, sizeof(cl_mem), &partialIndex);
+    clSetKernelArg(finalKernel, 3, sizeof(cl_mem), &resultMem);
+    clSetKernelArg(finalKernel, 4, finalLocal * sizeof(float), nullptr);
+    clSetKernelArg(finalKernel, 5, finalLocal * sizeof(int), nullptr);
+
+    const size_t globalWorkSize = groups * local;
+    double begin = omp_get_wtime();
+    clEnqueueNDRangeKernel(queue, partialKernel, 1, nullptr, &globalWorkSize, &local, 0, nullptr, nullptr);
+    clEnqueueNDRangeKernel(queue, finalKernel, 1, nullptr, &finalLocal, &finalLocal, 0, nullptr, nullptr);
+    clFinish(queue);
+    double end = omp_get_wtime();
+    clReleaseMemObject(partialValue);
+    clReleaseMemObject(partialIndex);
+    if (elapsed != nullptr)
+        *elapsed = end - begin;
+}
+
+int isamax_ocl(int n, const DeviceVector<float> &x, int incx, double *elapsed) {
+    if (n <= 0)
+        return -1;
+    DeviceVector<int> result(x.session(), 1);
+    isamax_ocl(n, x, incx, result, elapsed);
+    int index = 0;
+    result.download(&index);
+    return index;
+}
+
+// Element-wise kernels run one work-item per element with the global size rounded up to the work-group size
+static void enqueueElementwise(cl_kernel kernel, int n, Session &session, double *elapsed) {
+    size_t group = 0;
+    clGetKernelWorkGroupInfo(kernel, session.device(), CL_KERNEL_WORK_GROUP_SIZE, sizeof(size_t), &group, nullptr);
+    const size_t localWorkSize = std::min<size_t>(256u, std::max<size_t>(group, 1u));
+    const size_t globalWorkSize = (SAFE(n) + localWorkSize - 1) / localWorkSize * localWorkSize;
+    double begin = omp_get_wtime();
+    clEnqueueNDRangeKernel(session.queue(), kernel, 1, nullptr, &globalWorkSize, &localWorkSize, 0, nullptr, nullptr);
+    clFinish(session.queue());
+    double end = omp_get_wtime();
+    if (elapsed != nullptr)
+        *elapsed = end - begin;
+}
+
+void sscal_ocl(int n, float a, DeviceVector<float> &x, int incx, double *elapsed) {
+    if (n <= 0)
+        return;
+    Session &session = x.session();
+    cl_kernel kernel = session.kernel("blas1.cl", "scal", blasOptions<float>());
+    cl_mem xMem = x.buffer();
+    clSetKernelArg(kernel, 0, sizeof(int), &n);
+    clSetKernelArg(kernel, 1, sizeof(float), &a);
+    clSetKernelArg(kernel, 2, sizeof(cl_mem), &xMem);
+    clSetKernelArg(kernel, 3, sizeof(int), &incx);
+    enqueueElementwise(kernel, n, session, elapsed);
+}
+
+void saxpby_ocl(int n, float a, const DeviceVector<float> &x, int incx, float b, DeviceVector<float> &y, int incy,
+                double *elapsed) {
+    if (n <= 0)
+        return;
+    Session &session = y.session();
+    cl_kernel kernel = session.kernel("blas1.cl", "axpby", blasOptions<float>());
+    cl_mem xMem = x.buffer();
+    cl_mem yMem = y.buffer();
+    clSetKernelArg(kernel, 0, sizeof(int), &n);
+    clSetKernelArg(kernel, 1, sizeof(float), &a);
+    clSetKernelArg(kernel, 2, sizeof(cl_mem), &xMem);
+    clSetKernelArg(kernel, 3, sizeof(int), &incx);
+    clSetKernelArg(kernel, 4, sizeof(float), &b);
+    clSetKernelArg(kernel, 5, sizeof(cl_mem), &yMem);
+    clSetKernelArg(kernel, 6, sizeof(int), &incy);
+    enqueueElementwise(kernel, n, session, elapsed);
+}
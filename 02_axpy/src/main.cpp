@@ -2,6 +2,7 @@
 #define KERNELS_DIR
 #endif
 
+#include <cmath>
 #include <iostream>
 #include <vector>
 
@@ -9,6 +10,9 @@
 #include <omp.h>
 
 #include "axpy.hpp"
+#include "blas1.hpp"
+#include "programCache.hpp"
+#include "simd.hpp"
 #include "utils.hpp"
 
 int main() {
@@ -17,6 +21,8 @@ int main() {
 #pragma omp single
         std::cout << "OpenMP: " << omp_get_num_threads() << " threads" << std::endl;
     }
+    const double peakBandwidth = Utils::streamBandwidth();
+    std::cout << "SIMD: " << Simd::isaName() << ", STREAM triad: " << peakBandwidth << " GB/s" << std::endl;
 
     cl_uint platformCount = 0;
     clGetPlatformIDs(0, nullptr, &platformCount);
@@ -34,6 +40,182 @@ int main() {
     clGetDeviceInfo(gpuDeviceId, CL_DEVICE_NAME, 128, deviceName, nullptr);
     std::cout << "GPU: " << deviceName << std::endl;
 
+    Session cpuSession(cpuDeviceId);
+    Session gpuSession(gpuDeviceId);
+
+    {
+        std::cout << "---\nSmall-call latency\n";
+
+        constexpr int smallN = 4096;
+        constexpr int calls = 1000;
+        std::vector<float> x(smallN, 1.f);
+        std::vector<float> y(smallN, 2.f);
+
+        double begin = omp_get_wtime();
+        for (int i = 0; i < calls / 10; i++)
+            saxpy_ocl(smallN, 1.f, x.data(), 1, y.data(), 1, cpuDeviceId);
+        double end = omp_get_wtime();
+        std::cout << "OpenCL CPU per-call setup " << (end - begin) / (calls / 10) << std::endl;
+
+        saxpy_ocl(smallN, 1.f, x.data(), 1, y.data(), 1, cpuSession);
+        begin = omp_get_wtime();
+        for (int i = 0; i < calls; i++)
+            saxpy_ocl(smallN, 1.f, x.data(), 1, y.data(), 1, cpuSession);
+        end = omp_get_wtime();
+        std::cout << "OpenCL CPU session " << (end - begin) / calls << std::endl;
+    }
+
+    {
+        std::cout << "---\nArbitrary n\n";
+
+        for (int size : {1, 7, 255, 1'000'003}) {
+            std::vector<float> x(size, 1.f);
+            std::vector<float> y(size, 2.f);
+            std::vector<float> yTarget = y;
+            saxpy(size, 3.f, x.data(), 1, yTarget.data(), 1);
+            saxpy_ocl(size, 3.f, x.data(), 1, y.data(), 1, cpuSession);
+            std::cout << "n = " << size << ' ' << Utils::status(y == yTarget);
+            y.assign(size, 2.f);
+            saxpy_simd(size, 3.f, x.data(), 1, y.data(), 1);
+            std::cout << ", SIMD " << Utils::status(y == yTarget) << std::endl;
+        }
+    }
+
+    {
+        std::cout << "---\nBatched (count, n: loop of calls, batched CPU, batched GPU, OpenMP)\n";
+
+        for (int count : {100, 1000, 10'000}) {
+            for (int size : {16, 256, 4096}) {
+                std::vector<float> coefs(count, 3.f);
+                std::vector<float> x(static_cast<size_t>(count) * size, 1.f);
+                std::vector<float> yInit(static_cast<size_t>(count) * size, 2.f);
+                std::vector<float> yTarget = yInit;
+                for (int i = 0; i < count; i++)
+                    saxpy(size, coefs[i], x.data() + static_cast<size_t>(i) * size, 1,
+                          yTarget.data() + static_cast<size_t>(i) * size, 1);
+                std::cout << count << ", " << size << ": ";
+
+                auto y = yInit;
+                double begin = omp_get_wtime();
+                for (int i = 0; i < count; i++)
+                    saxpy_ocl(size, coefs[i], x.data() + static_cast<size_t>(i) * size, 1,
+                              y.data() + static_cast<size_t>(i) * size, 1, cpuSession);
+                double end = omp_get_wtime();
+                std::cout << (end - begin) << ' ' << Utils::status(y == yTarget) << ", ";
+
+                for (Session *session : {&cpuSession, &gpuSession}) {
+                    y = yInit;
+                    begin = omp_get_wtime();
+                    saxpy_ocl_batched(size, coefs.data(), x.data(), 1, size, y.data(), 1, size, count, *session);
+                    end = omp_get_wtime();
+                    std::cout << (end - begin) << ' ' << Utils::status(y == yTarget) << ", ";
+                }
+
+                y = yInit;
+                std::vector<AxpyBatchItem<float>> items(count);
+                for (int i = 0; i < count; i++)
+                    items[i] = {size, coefs[i], x.data() + static_cast<size_t>(i) * size, 1,
+                                y.data() + static_cast<size_t>(i) * size, 1};
+                begin = omp_get_wtime();
+                saxpy_batched_omp(items.data(), count);
+                end = omp_get_wtime();
+                std::cout << (end - begin) << ' ' << Utils::status(y == yTarget) << std::endl;
+            }
+        }
+    }
+
+    {
+        std::cout << "---\nBLAS level 1 (OpenMP, OpenCL CPU, OpenCL GPU)\n";
+
+        constexpr int size = 10'000'000;
+        std::vector<float> x(size);
+        std::vector<float> y(size);
+        for (int i = 0; i < size; i++) {
+            x[i] = static_cast<float>(i % 7) - 3.f;
+            y[i] = static_cast<float>(i % 5) * 0.5f;
+        }
+        x[size / 3] = 100.f;
+
+        float dot = sdot_omp(size, x.data(), 1, y.data(), 1);
+        float nrm2 = snrm2_omp(size, x.data(), 1);
+        float asum = sasum_omp(size, x.data(), 1);
+        int amax = isamax_omp(size, x.data(), 1);
+        std::cout << "dot " << dot << ", nrm2 " << nrm2 << ", asum " << asum << ", iamax " << amax << std::endl;
+
+        // Reductions are summed in a different order on the device, so they are compared relative to the sum of
+        // absolute terms, which for the dot product is far larger than the result itself
+        std::vector<double> xDouble(x.begin(), x.end());
+        std::vector<double> yDouble(y.begin(), y.end());
+        double dotScale = 0;
+        for (int i = 0; i < size; i++)
+            dotScale += std::abs(xDouble[i] * yDouble[i]);
+        double ddot = ddot_omp(size, xDouble.data(), 1, yDouble.data(), 1);
+        auto close = [](double value, double target, double scale, double tolerance) {
+            return std::abs(value - target) <= tolerance * scale;
+        };
+
+        for (Session *session : {&cpuSession, &gpuSession}) {
+            DeviceVector<float> xDev(*session, x.data(), size);
+            DeviceVector<float> yDev(*session, y.data(), size);
+            double elapsed = 0;
+            float dotDev = sdot_ocl(size, xDev, 1, yDev, 1, &elapsed);
+            float nrm2Dev = snrm2_ocl(size, xDev, 1);
+            float asumDev = sasum_ocl(size, xDev, 1);
+            int amaxDev = isamax_ocl(size, xDev, 1);
+            std::cout << "dot " << dotDev << " (" << elapsed << ") "
+                      << Utils::status(close(dotDev, dot, dotScale, 1e-4)) << ", nrm2 " << nrm2Dev << ' '
+                      << Utils::status(close(nrm2Dev, nrm2, nrm2, 1e-4)) << ", asum " << asumDev << ' '
+                      << Utils::status(close(asumDev, asum, asum, 1e-4)) << ", iamax " << amaxDev << ' '
+                      << Utils::status(amaxDev == amax) << std::endl;
+
+            // Results left on the device, downloaded only for the comparison
+            DeviceVector<float> resultDev(*session, 1);
+            DeviceVector<int> indexDev(*session, 1);
+            float result = 0;
+            int index = 0;
+            sdot_ocl(size, xDev, 1, yDev, 1, resultDev);
+            resultDev.download(&result);
+            bool resident = close(result, dot, dotScale, 1e-4);
+            snrm2_ocl(size, xDev, 1, resultDev);
+            resultDev.download(&result);
+            resident = resident && close(result, nrm2, nrm2, 1e-4);
+            sasum_ocl(size, xDev, 1, resultDev);
+            resultDev.download(&result);
+            resident = resident && close(result, asum, asum, 1e-4);
+            isamax_ocl(size, xDev, 1, indexDev);
+            indexDev.download(&index);
+            resident = resident && index == amax;
+            std::cout << "results on device " << Utils::status(resident) << ", ";
+
+            cl_device_fp_config doubleConfig = 0;
+            clGetDeviceInfo(session->device(), CL_DEVICE_DOUBLE_FP_CONFIG, sizeof(doubleConfig), &doubleConfig,
+                            nullptr);
+            if (doubleConfig != 0) {
+                DeviceVector<double> xDoubleDev(*session, xDouble.data(), size);
+                DeviceVector<double> yDoubleDev(*session, yDouble.data(), size);
+                DeviceVector<double> ddotDev(*session, 1);
+                double ddotResult = 0;
+                ddot_ocl(size, xDoubleDev, 1, yDoubleDev, 1, ddotDev);
+                ddotDev.download(&ddotResult);
+                bool ok = close(ddot_ocl(size, xDoubleDev, 1, yDoubleDev, 1), ddot, dotScale, 1e-12) &&
+                          close(ddotResult, ddot, dotScale, 1e-12);
+                std::cout << "ddot " << Utils::status(ok) << std::endl;
+            } else {
+                std::cout << "ddot skipped, no double precision" << std::endl;
+            }
+
+            // y = 2 * (0.5 * x + y), compared with the same update on the host
+            auto yTarget = y;
+            saxpby_omp(size, 0.5f, x.data(), 1, 1.f, yTarget.data(), 1);
+            sscal_omp(size, 2.f, yTarget.data(), 1);
+            saxpby_ocl(size, 0.5f, xDev, 1, 1.f, yDev, 1);
+            sscal_ocl(size, 2.f, yDev, 1);
+            std::vector<float> yResult(size);
+            yDev.download(yResult.data());
+            std::cout << "axpby + scal " << Utils::status(yResult == yTarget) << std::endl;
+        }
+    }
+
     constexpr int n = 100'000'000;
     constexpr int incy = 2;
     constexpr int incx = 3;
@@ -44,15 +226,15 @@ int main() {
     {
         std::cout << "---\nSingle-precision\n";
 
-        std::vector<float> xInit(xSize, 0.f);
+        Utils::AlignedVector<float> xInit(xSize, 0.f);
         Utils::fillWithStride(xInit, 1.f, incx);
         // Utils::print(xInit);
 
-        std::vector<float> yInit(ySize, 0.f);
+        Utils::AlignedVector<float> yInit(ySize, 0.f);
         Utils::fillWithStride(yInit, 2.f, incy);
         // Utils::print(yInit);
 
-        std::vector<float> yTarget;
+        Utils::AlignedVector<float> yTarget;
 
         {
             std::cout << "Sequential ";
@@ -61,10 +243,25 @@ int main() {
             double begin = omp_get_wtime();
             saxpy(n, a, xInit.data(), incx, y.data(), incy);
             double end = omp_get_wtime();
-            std::cout << (end - begin) << std::endl;
+            double bandwidth = 3. * n * sizeof(float) / (end - begin) / 1e9;
+            std::cout << (end - begin) << ' ' << bandwidth << " GB/s (" << 100 * bandwidth / peakBandwidth << "%)";
+            std::cout << std::endl;
             yTarget = y;
         }
 
+        // Inputs are small integers, so FMA kernels round the same as the plain loop and results compare exactly
+        {
+            std::cout << "SIMD " << Simd::isaName() << ' ';
+
+            auto y = yInit;
+            double begin = omp_get_wtime();
+            saxpy_simd(n, a, xInit.data(), incx, y.data(), incy);
+            double end = omp_get_wtime();
+            double bandwidth = 3. * n * sizeof(float) / (end - begin) / 1e9;
+            std::cout << (end - begin) << ' ' << bandwidth << " GB/s (" << 100 * bandwidth / peakBandwidth << "%) ";
+            std::cout << Utils::status(y == yTarget) << std::endl;
+        }
+
         {
             std::cout << "OpenMP ";
 
@@ -72,7 +269,8 @@ int main() {
             double begin = omp_get_wtime();
             saxpy_omp(n, a, xInit.data(), incx, y.data(), incy);
             double end = omp_get_wtime();
-            std::cout << (end - begin) << ' ';
+            double bandwidth = 3. * n * sizeof(float) / (end - begin) / 1e9;
+            std::cout << (end - begin) << ' ' << bandwidth << " GB/s (" << 100 * bandwidth / peakBandwidth << "%) ";
             std::cout << Utils::status(y == yTarget) << std::endl;
         }
 
@@ -81,34 +279,90 @@ int main() {
 
             auto y = yInit;
             double elapsed = 0;
-            saxpy_ocl(n, a, xInit.data(), incx, y.data(), incy, cpuDeviceId, &elapsed);
+            TransferStats transfer;
+            saxpy_ocl(n, a, xInit.data(), incx, y.data(), incy, cpuSession, &elapsed, &transfer);
             std::cout << elapsed << ' ';
             std::cout << Utils::status(y == yTarget) << std::endl;
+            std::cout << "Transferred " << transfer.bytes << " bytes, saved " << transfer.bytesSaved << " bytes"
+                      << std::endl;
         }
 
+        for (bool zeroCopy : {false, true}) {
+            std::cout << (zeroCopy ? "OpenCL CPU zero-copy " : "OpenCL CPU copy ");
+
+            auto y = yInit;
+            cpuSession.setZeroCopy(zeroCopy);
+            double begin = omp_get_wtime();
+            saxpy_ocl(n, a, xInit.data(), incx, y.data(), incy, cpuSession);
+            double end = omp_get_wtime();
+            std::cout << (end - begin) << ' ';
+            std::cout << Utils::status(y == yTarget) << std::endl;
+        }
+        cpuSession.setZeroCopy(cpuSession.unifiedMemory());
+
         {
             std::cout << "OpenCL GPU ";
 
             auto y = yInit;
             double elapsed = 0;
-            saxpy_ocl(n, a, xInit.data(), incx, y.data(), incy, gpuDeviceId, &elapsed);
+            saxpy_ocl(n, a, xInit.data(), incx, y.data(), incy, gpuSession, &elapsed);
+            std::cout << elapsed << ' ';
+            std::cout << Utils::status(y == yTarget) << std::endl;
+        }
+
+        for (Session *session : {&cpuSession, &gpuSession}) {
+            std::cout << (session == &cpuSession ? "OpenCL CPU pipelined " : "OpenCL GPU pipelined ");
+
+            auto y = yInit;
+            double elapsed = 0;
+            saxpy_ocl_pipelined(n, a, xInit.data(), incx, y.data(), incy, *session, 0, &elapsed);
             std::cout << elapsed << ' ';
             std::cout << Utils::status(y == yTarget) << std::endl;
         }
+
+        {
+            std::cout << "OpenCL CPU resident ";
+
+            auto y = yInit;
+            double elapsed = 0;
+            double begin = omp_get_wtime();
+            DeviceVector<float> xDev(cpuSession, xInit.data(), xSize);
+            DeviceVector<float> yDev(cpuSession, y.data(), ySize);
+            saxpy_ocl(n, a, xDev, incx, yDev, incy, &elapsed);
+            yDev.download(y.data());
+            double end = omp_get_wtime();
+            std::cout << elapsed << ' ' << (end - begin) << ' ';
+            std::cout << Utils::status(y == yTarget) << std::endl;
+        }
+
+        {
+            std::cout << "OpenCL GPU resident ";
+
+            auto y = yInit;
+            double elapsed = 0;
+            double begin = omp_get_wtime();
+            DeviceVector<float> xDev(gpuSession, xInit.data(), xSize);
+            DeviceVector<float> yDev(gpuSession, y.data(), ySize);
+            saxpy_ocl(n, a, xDev, incx, yDev, incy, &elapsed);
+            yDev.download(y.data());
+            double end = omp_get_wtime();
+            std::cout << elapsed << ' ' << (end - begin) << ' ';
+            std::cout << Utils::status(y == yTarget) << std::endl;
+        }
     }
 
     {
         std::cout << "---\nDouble-precision\n";
 
-        std::vector<double> xInit(xSize, 0.);
+        Utils::AlignedVector<double> xInit(xSize, 0.);
         Utils::fillWithStride(xInit, 1., incx);
         // Utils::print(xInit);
 
-        std::vector<double> yInit(ySize, 0.);
+        Utils::AlignedVector<double> yInit(ySize, 0.);
         Utils::fillWithStride(yInit, 2., incy);
         // Utils::print(yInit);
 
-        std::vector<double> yTarget;
+        Utils::AlignedVector<double> yTarget;
 
         {
             std::cout << "Sequential ";
@@ -117,10 +371,24 @@ int main() {
             double begin = omp_get_wtime();
             daxpy(n, a, xInit.data(), incx, y.data(), incy);
             double end = omp_get_wtime();
-            std::cout << (end - begin) << std::endl;
+            double bandwidth = 3. * n * sizeof(double) / (end - begin) / 1e9;
+            std::cout << (end - begin) << ' ' << bandwidth << " GB/s (" << 100 * bandwidth / peakBandwidth << "%)";
+            std::cout << std::endl;
             yTarget = y;
         }
 
+        {
+            std::cout << "SIMD " << Simd::isaName() << ' ';
+
+            auto y = yInit;
+            double begin = omp_get_wtime();
+            daxpy_simd(n, a, xInit.data(), incx, y.data(), incy);
+            double end = omp_get_wtime();
+            double bandwidth = 3. * n * sizeof(double) / (end - begin) / 1e9;
+            std::cout << (end - begin) << ' ' << bandwidth << " GB/s (" << 100 * bandwidth / peakBandwidth << "%) ";
+            std::cout << Utils::status(y == yTarget) << std::endl;
+        }
+
         {
             std::cout << "OpenMP ";
 
@@ -128,7 +396,8 @@ int main() {
             double begin = omp_get_wtime();
             daxpy_omp(n, a, xInit.data(), incx, y.data(), incy);
             double end = omp_get_wtime();
-            std::cout << (end - begin) << ' ';
+            double bandwidth = 3. * n * sizeof(double) / (end - begin) / 1e9;
+            std::cout << (end - begin) << ' ' << bandwidth << " GB/s (" << 100 * bandwidth / peakBandwidth << "%) ";
             std::cout << Utils::status(y == yTarget) << std::endl;
         }
 
@@ -137,21 +406,81 @@ int main() {
 
             auto y = yInit;
             double elapsed = 0;
-            daxpy_ocl(n, a, xInit.data(), incx, y.data(), incy, cpuDeviceId, &elapsed);
+            TransferStats transfer;
+            daxpy_ocl(n, a, xInit.data(), incx, y.data(), incy, cpuSession, &elapsed, &transfer);
             std::cout << elapsed << ' ';
             std::cout << Utils::status(y == yTarget) << std::endl;
+            std::cout << "Transferred " << transfer.bytes << " bytes, saved " << transfer.bytesSaved << " bytes"
+                      << std::endl;
         }
 
+        for (bool zeroCopy : {false, true}) {
+            std::cout << (zeroCopy ? "OpenCL CPU zero-copy " : "OpenCL CPU copy ");
+
+            auto y = yInit;
+            cpuSession.setZeroCopy(zeroCopy);
+            double begin = omp_get_wtime();
+            daxpy_ocl(n, a, xInit.data(), incx, y.data(), incy, cpuSession);
+            double end = omp_get_wtime();
+            std::cout << (end - begin) << ' ';
+            std::cout << Utils::status(y == yTarget) << std::endl;
+        }
+        cpuSession.setZeroCopy(cpuSession.unifiedMemory());
+
         {
             std::cout << "OpenCL GPU ";
 
             auto y = yInit;
             double elapsed = 0;
-            daxpy_ocl(n, a, xInit.data(), incx, y.data(), incy, gpuDeviceId, &elapsed);
+            daxpy_ocl(n, a, xInit.data(), incx, y.data(), incy, gpuSession, &elapsed);
             std::cout << elapsed << ' ';
             std::cout << Utils::status(y == yTarget) << std::endl;
         }
+
+        for (Session *session : {&cpuSession, &gpuSession}) {
+            std::cout << (session == &cpuSession ? "OpenCL CPU pipelined " : "OpenCL GPU pipelined ");
+
+            auto y = yInit;
+            double elapsed = 0;
+            daxpy_ocl_pipelined(n, a, xInit.data(), incx, y.data(), incy, *session, 0, &elapsed);
+            std::cout << elapsed << ' ';
+            std::cout << Utils::status(y == yTarget) << std::endl;
+        }
+
+        {
+            std::cout << "OpenCL CPU resident ";
+
+            auto y = yInit;
+            double elapsed = 0;
+            double begin = omp_get_wtime();
+            DeviceVector<double> xDev(cpuSession, xInit.data(), xSize);
+            DeviceVector<double> yDev(cpuSession, y.data(), ySize);
+            daxpy_ocl(n, a, xDev, incx, yDev, incy, &elapsed);
+            yDev.download(y.data());
+            double end = omp_get_wtime();
+            std::cout << elapsed << ' ' << (end - begin) << ' ';
+            std::cout << Utils::status(y == yTarget) << std::endl;
+        }
+
+        {
+            std::cout << "OpenCL GPU resident ";
+
+            auto y = yInit;
+            double elapsed = 0;
+            double begin = omp_get_wtime();
+            DeviceVector<double> xDev(gpuSession, xInit.data(), xSize);
+            DeviceVector<double> yDev(gpuSession, y.data(), ySize);
+            daxpy_ocl(n, a, xDev, incx, yDev, incy, &elapsed);
+            yDev.download(y.data());
+            double end = omp_get_wtime();
+            std::cout << elapsed << ' ' << (end - begin) << ' ';
+            std::cout << Utils::status(y == yTarget) << std::endl;
+        }
     }
 
+    const ProgramCache::Stats &cacheStats = ProgramCache::stats();
+    std::cout << "---\nProgram cache: " << cacheStats.hits << " hits, " << cacheStats.misses << " misses, build time "
+              << cacheStats.buildTime << std::endl;
+
     delete[] platform;
 }
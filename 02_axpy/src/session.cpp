@@ -0,0 +1,70 @@
+#include "session.hpp"
+
+#include "programCache.hpp"
+
+Session::Session(cl_device_id deviceId) : deviceId(deviceId) {
+    ctx = clCreateContext(nullptr, 1, &deviceId, nullptr, nullptr, nullptr);
+    queues.push_back(clCreateCommandQueue(ctx, deviceId, 0, nullptr));
+    cl_bool hostUnifiedMemory = CL_FALSE;
+    clGetDeviceInfo(deviceId, CL_DEVICE_HOST_UNIFIED_MEMORY, sizeof(cl_bool), &hostUnifiedMemory, nullptr);
+    unified = hostUnifiedMemory == CL_TRUE;
+    useHostPtr = unified;
+}
+
+Session::~Session() {
+    for (auto &item : kernels)
+        clReleaseKernel(item.second);
+    for (auto &item : programs)
+        clReleaseProgram(item.second);
+    for (cl_command_queue queue : queues)
+        clReleaseCommandQueue(queue);
+    clReleaseContext(ctx);
+}
+
+cl_device_id Session::device() const {
+    return deviceId;
+}
+
+cl_context Session::context() const {
+    return ctx;
+}
+
+cl_command_queue Session::queue(size_t index) {
+    while (queues.size() <= index)
+        queues.push_back(clCreateCommandQueue(ctx, deviceId, 0, nullptr));
+    return queues[index];
+}
+
+bool Session::unifiedMemory() const {
+    return unified;
+}
+
+bool Session::zeroCopy() const {
+    return useHostPtr;
+}
+
+void Session::setZeroCopy(bool enabled) {
+    useHostPtr = enabled;
+}
+
+cl_program Session::program(const std::string &file, const std::string &options) {
+    std::string key = file + '|' + options;
+    auto it = programs.find(key);
+    if (it != programs.end())
+        return it->second;
+
+    cl_program program = ProgramCache::build(ctx, deviceId, file, options);
+    programs.emplace(key, program);
+    return program;
+}
+
+cl_kernel Session::kernel(const std::string &file, const std::string &name, const std::string &options) {
+    std::string key = file + '|' + options + '|' + name;
+    auto it = kernels.find(key);
+    if (it != kernels.end())
+        return it->second;
+
+    cl_kernel kernel = clCreateKernel(program(file, options), name.c_str(), nullptr);
+    kernels.emplace(key, kernel);
+    return kernel;
+}
@@ -0,0 +1,240 @@
+#include "simd.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_X86
+#endif
+
+#define AXPY_IMPL                                                                                                      \
+    for (int i = 0; i < n; i++)                                                                                        \
+        y[i * incy] += a * x[i * incx];
+
+enum class Isa { Generic, Sse, Avx2, Avx512 };
+
+static void saxpyGeneric(int n, float a, const float *x, int incx, float *y, int incy) {
+    AXPY_IMPL
+}
+
+static void daxpyGeneric(int n, double a, const double *x, int incx, double *y, int incy) {
+    AXPY_IMPL
+}
+
+#ifdef SIMD_X86
+
+static void saxpySse(int n, float a, const float *x, int incx, float *y, int incy) {
+    if (incx != 1 || incy != 1)
+        return saxpyGeneric(n, a, x, incx, y, incy);
+    __m128 va = _mm_set1_ps(a);
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(va, _mm_loadu_ps(x + i))));
+    for (; i < n; i++)
+        y[i] += a * x[i];
+}
+
+static void daxpySse(int n, double a, const double *x, int incx, double *y, int incy) {
+    if (incx != 1 || incy != 1)
+        return daxpyGeneric(n, a, x, incx, y, incy);
+    __m128d va = _mm_set1_pd(a);
+    int i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(va, _mm_loadu_pd(x + i))));
+    for (; i < n; i++)
+        y[i] += a * x[i];
+}
+
+__attribute__((target("avx2,fma"))) static void saxpyAvx2(int n, float a, const float *x, int incx, float *y,
+                                                           int incy) {
+    if (incx <= 0 || incy <= 0)
+        return saxpyGeneric(n, a, x, incx, y, incy);
+    __m256 va = _mm256_set1_ps(a);
+    int i = 0;
+    if (incx == 1 && incy == 1) {
+        for (; i + 16 <= n; i += 16) {
+            __m256 y0 = _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i));
+            __m256 y1 = _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8));
+            _mm256_storeu_ps(y + i, y0);
+            _mm256_storeu_ps(y + i + 8, y1);
+        }
+    } else {
+        // AVX2 has gather but no scatter, so y lanes are stored one by one
+        __m256i xIndex = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(incx));
+        __m256i yIndex = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(incy));
+        alignas(32) float lanes[8];
+        for (; i + 8 <= n; i += 8) {
+            const float *xBase = x + static_cast<long long>(i) * incx;
+            float *yBase = y + static_cast<long long>(i) * incy;
+            __m256 vx = _mm256_i32gather_ps(xBase, xIndex, 4);
+            __m256 vy = _mm256_i32gather_ps(yBase, yIndex, 4);
+            _mm256_store_ps(lanes, _mm256_fmadd_ps(va, vx, vy));
+            for (int l = 0; l < 8; l++)
+                yBase[l * incy] = lanes[l];
+        }
+    }
+    for (; i < n; i++)
+        y[static_cast<long long>(i) * incy] += a * x[static_cast<long long>(i) * incx];
+}
+
+__attribute__((target("avx2,fma"))) static void daxpyAvx2(int n, double a, const double *x, int incx, double *y,
+                                                           int incy) {
+    if (incx <= 0 || incy <= 0)
+        return daxpyGeneric(n, a, x, incx, y, incy);
+    __m256d va = _mm256_set1_pd(a);
+    int i = 0;
+    if (incx == 1 && incy == 1) {
+        for (; i + 8 <= n; i += 8) {
+            __m256d y0 = _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i));
+            __m256d y1 = _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4));
+            _mm256_storeu_pd(y + i, y0);
+            _mm256_storeu_pd(y + i + 4, y1);
+        }
+    } else {
+        __m128i xIndex = _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(incx));
+        __m128i yIndex = _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(incy));
+        alignas(32) double lanes[4];
+        for (; i + 4 <= n; i += 4) {
+            const double *xBase = x + static_cast<long long>(i) * incx;
+            double *yBase = y + static_cast<long long>(i) * incy;
+            __m256d vx = _mm256_i32gather_pd(xBase, xIndex, 8);
+            __m256d vy = _mm256_i32gather_pd(yBase, yIndex, 8);
+            _mm256_store_pd(lanes, _mm256_fmadd_pd(va, vx, vy));
+            for (int l = 0; l < 4; l++)
+                yBase[l * incy] = lanes[l];
+        }
+    }
+    for (; i < n; i++)
+        y[static_cast<long long>(i) * incy] += a * x[static_cast<long long>(i) * incx];
+}
+
+__attribute__((target("avx512f"))) static void saxpyAvx512(int n, float a, const float *x, int incx, float *y,
+                                                            int incy) {
+    if (incx <= 0 || incy <= 0)
+        return saxpyGeneric(n, a, x, incx, y, incy);
+    __m512 va = _mm512_set1_ps(a);
+    int i = 0;
+    if (incx == 1 && incy == 1) {
+        for (; i + 32 <= n; i += 32) {
+            __m512 y0 = _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i));
+            __m512 y1 = _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i + 16), _mm512_loadu_ps(y + i + 16));
+            _mm512_storeu_ps(y + i, y0);
+            _mm512_storeu_ps(y + i + 16, y1);
+        }
+        for (; i < n; i += 16) {
+            __mmask16 mask = static_cast<__mmask16>((1u << (n - i < 16 ? n - i : 16)) - 1);
+            __m512 vx = _mm512_maskz_loadu_ps(mask, x + i);
+            __m512 vy = _mm512_maskz_loadu_ps(mask, y + i);
+            _mm512_mask_storeu_ps(y + i, mask, _mm512_fmadd_ps(va, vx, vy));
+        }
+        return;
+    }
+    __m512i lane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m512i xIndex = _mm512_mullo_epi32(lane, _mm512_set1_epi32(incx));
+    __m512i yIndex = _mm512_mullo_epi32(lane, _mm512_set1_epi32(incy));
+    for (; i + 16 <= n; i += 16) {
+        const float *xBase = x + static_cast<long long>(i) * incx;
+        float *yBase = y + static_cast<long long>(i) * incy;
+        __m512 vx = _mm512_i32gather_ps(xIndex, xBase, 4);
+        __m512 vy = _mm512_i32gather_ps(yIndex, yBase, 4);
+        _mm512_i32scatter_ps(yBase, yIndex, _mm512_fmadd_ps(va, vx, vy), 4);
+    }
+    for (; i < n; i++)
+        y[static_cast<long long>(i) * incy] += a * x[static_cast<long long>(i) * incx];
+}
+
+__attribute__((target("avx512f"))) static void daxpyAvx512(int n, double a, const double *x, int incx, double *y,
+                                                            int incy) {
+    if (incx <= 0 || incy <= 0)
+        return daxpyGeneric(n, a, x, incx, y, incy);
+    __m512d va = _mm512_set1_pd(a);
+    int i = 0;
+    if (incx == 1 && incy == 1) {
+        for (; i + 16 <= n; i += 16) {
+            __m512d y0 = _mm512_fmadd_pd(va, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i));
+            __m512d y1 = _mm512_fmadd_pd(va, _mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8));
+            _mm512_storeu_pd(y + i, y0);
+            _mm512_storeu_pd(y + i + 8, y1);
+        }
+        for (; i < n; i += 8) {
+            __mmask8 mask = static_cast<__mmask8>((1u << (n - i < 8 ? n - i : 8)) - 1);
+            __m512d vx = _mm512_maskz_loadu_pd(mask, x + i);
+            __m512d vy = _mm512_maskz_loadu_pd(mask, y + i);
+            _mm512_mask_storeu_pd(y + i, mask, _mm512_fmadd_pd(va, vx, vy));
+        }
+        return;
+    }
+    __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i xIndex = _mm256_mullo_epi32(lane, _mm256_set1_epi32(incx));
+    __m256i yIndex = _mm256_mullo_epi32(lane, _mm256_set1_epi32(incy));
+    for (; i + 8 <= n; i += 8) {
+        const double *xBase = x + static_cast<long long>(i) * incx;
+        double *yBase = y + static_cast<long long>(i) * incy;
+        __m512d vx = _mm512_i32gather_pd(xIndex, xBase, 8);
+        __m512d vy = _mm512_i32gather_pd(yIndex, yBase, 8);
+        _mm512_i32scatter_pd(yBase, yIndex, _mm512_fmadd_pd(va, vx, vy), 8);
+    }
+    for (; i < n; i++)
+        y[static_cast<long long>(i) * incy] += a * x[static_cast<long long>(i) * incx];
+}
+
+#endif
+
+static Isa detectIsa() {
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return Isa::Avx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return Isa::Avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return Isa::Sse;
+#endif
+    return Isa::Generic;
+}
+
+static Isa isa() {
+    static const Isa detected = detectIsa();
+    return detected;
+}
+
+Simd::SaxpyKernel Simd::saxpyKernel() {
+    switch (isa()) {
+#ifdef SIMD_X86
+    case Isa::Avx512:
+        return saxpyAvx512;
+    case Isa::Avx2:
+        return saxpyAvx2;
+    case Isa::Sse:
+        return saxpySse;
+#endif
+    default:
+        return saxpyGeneric;
+    }
+}
+
+Simd::DaxpyKernel Simd::daxpyKernel() {
+    switch (isa()) {
+#ifdef SIMD_X86
+    case Isa::Avx512:
+        return daxpyAvx512;
+    case Isa::Avx2:
+        return daxpyAvx2;
+    case Isa::Sse:
+        return daxpySse;
+#endif
+    default:
+        return daxpyGeneric;
+    }
+}
+
+const char *Simd::isaName() {
+    switch (isa()) {
+    case Isa::Avx512:
+        return "AVX-512";
+    case Isa::Avx2:
+        return "AVX2";
+    case Isa::Sse:
+        return "SSE2";
+    default:
+        return "generic";
+    }
+}
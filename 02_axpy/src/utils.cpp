@@ -3,6 +3,8 @@
 #include <fstream>
 #include <iostream>
 
+#include <omp.h>
+
 std::string Utils::readFile(const std::string &path) {
     std::ifstream file(path);
     std::string content, str;
@@ -18,3 +20,25 @@ std::string Utils::status(bool ok) {
         return "OK";
     return "FAIL";
 }
+
+double Utils::streamBandwidth() {
+    constexpr size_t size = 1 << 25;
+    constexpr int repeats = 5;
+    AlignedVector<double> a(size), b(size), c(size);
+#pragma omp parallel for
+    for (size_t i = 0; i < size; i++) {
+        a[i] = 0.;
+        b[i] = 1.;
+        c[i] = 2.;
+    }
+    double best = 0;
+    for (int r = 0; r < repeats; r++) {
+        double begin = omp_get_wtime();
+#pragma omp parallel for
+        for (size_t i = 0; i < size; i++)
+            a[i] = b[i] + 3. * c[i];
+        double end = omp_get_wtime();
+        best = std::max(best, 3 * size * sizeof(double) / (end - begin) / 1e9);
+    }
+    return best;
+}
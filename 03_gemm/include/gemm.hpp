@@ -0,0 +1,40 @@
+#pragma once
+
+#include <CL/cl.h>
+
+/**
+ * BLAS-style GEMM with by-row layout: c = alpha * op(a) * op(b) + beta * c, where op(a) is m x k, op(b) is k x n
+ * and c is m x n (BLAS naming, unlike multiply where n is the inner dimension). lda, ldb and ldc are row strides
+ * of the stored matrices, transposed operands are read in place. With beta = 0 c is not read.
+ */
+enum class Op { NoTrans, Trans };
+
+/**
+ * Batched variants multiply batch independent matrices of the same shape: either placed strideA, strideB and strideC
+ * elements apart or given by arrays of pointers
+ */
+
+namespace omp {
+void sgemm(Op transA, Op transB, int m, int n, int k, float alpha, const float *a, int lda, const float *b, int ldb,
+           float beta, float *c, int ldc);
+void dgemm(Op transA, Op transB, int m, int n, int k, double alpha, const double *a, int lda, const double *b,
+           int ldb, double beta, double *c, int ldc);
+void sgemmStridedBatched(Op transA, Op transB, int m, int n, int k, float alpha, const float *a, int lda, int strideA,
+                         const float *b, int ldb, int strideB, float beta, float *c, int ldc, int strideC, int batch);
+void sgemmBatched(Op transA, Op transB, int m, int n, int k, float alpha, const float *const *a, int lda,
+                  const float *const *b, int ldb, float beta, float *const *c, int ldc, int batch);
+} // namespace omp
+
+namespace ocl {
+void sgemm(Op transA, Op transB, int m, int n, int k, float alpha, const float *a, int lda, const float *b, int ldb,
+           float beta, float *c, int ldc, cl_device_id deviceId, float *elapsed = nullptr);
+// Falls back to omp::dgemm on devices without double precision support
+void dgemm(Op transA, Op transB, int m, int n, int k, double alpha, const double *a, int lda, const double *b,
+           int ldb, double beta, double *c, int ldc, cl_device_id deviceId, float *elapsed = nullptr);
+void sgemmStridedBatched(Op transA, Op transB, int m, int n, int k, float alpha, const float *a, int lda, int strideA,
+                         const float *b, int ldb, int strideB, float beta, float *c, int ldc, int strideC, int batch,
+                         cl_device_id deviceId, float *elapsed = nullptr);
+void sgemmBatched(Op transA, Op transB, int m, int n, int k, float alpha, const float *const *a, int lda,
+                  const float *const *b, int ldb, float beta, float *const *c, int ldc, int batch,
+                  cl_device_id deviceId, float *elapsed = nullptr);
+} // namespace ocl
@@ -0,0 +1,16 @@
+#pragma once
+
+namespace HostGemm {
+
+/**
+ * Cache-blocked host GEMM in the BLIS style: c = a * b with by-row layout (a is m x n, b is n x k, c is m x k).
+ * Panels of b (KC x NC) and a (MC x KC) are packed into contiguous buffers sized for L3 and L2, a register
+ * micro-kernel computes MR x NR blocks of c from them. The micro-kernel is selected at runtime (AVX-512, AVX2+FMA
+ * or generic), OpenMP threads share packed panels and split the loop over NR-wide columns.
+ */
+void multiply(const float *a, const float *b, float *c, int m, int n, int k);
+
+// Instruction set of the selected micro-kernel
+const char *isaName();
+
+} // namespace HostGemm
@@ -1,15 +1,55 @@
 #pragma once
 
+#include <cstddef>
+
 #include <CL/cl.h>
 
+#include "precision.hpp"
+
 void multiply(float *a, float *b, float *c, int m, int n, int k);
 
 namespace omp {
+// Packed and cache-blocked, see HostGemm::multiply
 void multiply(float *a, float *b, float *c, int m, int n, int k);
 } // namespace omp
 
 namespace ocl {
-void multiply(float *a, float *b, float *c, int m, int n, int k, cl_device_id deviceId, float *elapsed);
-void multiplyBlock(float *a, float *b, float *c, int m, int n, int k, cl_device_id deviceId, float *elapsed);
+/**
+ * Host-device data movement: ZeroCopy wraps host arrays with CL_MEM_USE_HOST_PTR and maps the result instead of
+ * copying, Auto selects it for devices reporting CL_DEVICE_HOST_UNIFIED_MEMORY
+ */
+enum class Transfer { Auto, Copy, ZeroCopy };
+
+// Dispatches to multiplyTiled
+void multiply(float *a, float *b, float *c, int m, int n, int k, cl_device_id deviceId, float *elapsed,
+              Transfer transfer = Transfer::Auto);
+// Falls back to multiplyTiled for shapes multiplyBlockOptimal does not support
+void multiplyBlock(float *a, float *b, float *c, int m, int n, int k, cl_device_id deviceId, float *elapsed,
+                   Transfer transfer = Transfer::Auto);
+// Register-tiled kernel, any m, n, k, uses the tuned configuration for the device if there is one
+void multiplyTiled(float *a, float *b, float *c, int m, int n, int k, cl_device_id deviceId, float *elapsed,
+                   Transfer transfer = Transfer::Auto);
+/**
+ * Mixed precision: a and b are converted on the host to 16-bit storage and multiplied by gemmTiled with float
+ * accumulation, bytes gets the amount of data moved between host and device
+ */
+void multiplyMixed(float *a, float *b, float *c, int m, int n, int k, Precision::Storage storage,
+                   cl_device_id deviceId, float *elapsed, size_t *bytes = nullptr);
+/**
+ * Strassen-Winograd recursion over the tiled kernel for square matrices: at most depth levels, matrices of
+ * cutoff or less and odd sizes are multiplied directly, without splitting. Temporaries live in one device arena
+ * allocated per call. Other shapes fall back to multiplyTiled.
+ */
+void multiplyStrassen(float *a, float *b, float *c, int m, int n, int k, cl_device_id deviceId, float *elapsed,
+                      int depth = 2, int cutoff = 512);
+/**
+ * Out-of-core: c is computed tile by tile while the matching panels of a and b are streamed through two pipeline
+ * slots that together stay within budget bytes of device memory (half the global memory if 0, tiles are
+ * never smaller than 16 x 16). elapsed includes
+ * the transfers, bytes gets the amount of data moved between host and device.
+ */
+void multiplyOutOfCore(float *a, float *b, float *c, int m, int n, int k, cl_device_id deviceId, float *elapsed,
+                       size_t budget = 0, size_t *bytes = nullptr);
+// Matrices in RGBA float images (4 elements per texel), any m, n, k
 void multiplyImage(float *a, float *b, float *c, int m, int n, int k, cl_device_id deviceId, float *elapsed);
 } // namespace ocl
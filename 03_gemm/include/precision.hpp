@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Precision {
+
+/**
+ * 16-bit storage formats: Half is IEEE fp16, BFloat16 keeps the float exponent with a 7-bit mantissa
+ * (the upper half of a float). Conversions to 16 bits round to nearest even.
+ */
+enum class Storage { Half, BFloat16 };
+
+uint16_t toHalf(float value);
+float fromHalf(uint16_t value);
+uint16_t toBFloat16(float value);
+float fromBFloat16(uint16_t value);
+
+/**
+ * Compares toHalf over every float bit pattern and fromHalf over every fp16 pattern with the F16C conversions,
+ * NaNs only have to stay NaNs of the same sign. Returns the number of mismatches, -1 without F16C.
+ */
+long long checkHalf();
+
+// Converts size elements with OpenMP
+void convert(const float *src, uint16_t *dst, size_t size, Storage storage);
+void convert(const uint16_t *src, float *dst, size_t size, Storage storage);
+
+} // namespace Precision
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+
+#include <CL/cl.h>
+
+namespace Tuner {
+
+/**
+ * Build parameters of gemmTiled (kernels/gemm.cl): tile of c per work-group, depth of panels,
+ * micro-tile per work-item and unroll factor of the inner loop. blockSize is BLOCK_SIZE of multiplyBlockOptimal
+ * (kernels/multiplyBlock.cl), which runs blockSize x blockSize work-groups.
+ */
+struct GemmConfig {
+    int tileM = 64;
+    int tileK = 64;
+    int tileN = 16;
+    int wptM = 4;
+    int wptK = 4;
+    int unroll = 1;
+    int blockSize = 16;
+
+    std::string options() const;
+    std::string blockOptions() const;
+    size_t localM() const;
+    size_t localK() const;
+};
+
+/**
+ * Tuned configuration for the device and size class of the problem from TUNING_FILE,
+ * defaults if the pair has not been tuned. The file is read once.
+ */
+GemmConfig gemmConfig(cl_device_id deviceId, int m, int n, int k);
+
+/**
+ * Times every valid configuration on random m x n and n x k matrices with profiling events,
+ * stores the fastest one for the device and size class in TUNING_FILE and returns it
+ */
+GemmConfig tuneGemm(cl_device_id deviceId, int m, int n, int k, bool verbose = false);
+
+} // namespace Tuner
@@ -1,25 +1,75 @@
 #pragma once
 
 #include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
+#include <new>
 #include <random>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace Utils {
 
 std::string readFile(const std::string &path);
 
+/**
+ * Allocator returning page-aligned storage, which OpenCL runtimes can use in place with CL_MEM_USE_HOST_PTR.
+ * Default-inserted elements are left uninitialized so that big buffers are first touched by the code filling them.
+ */
+template <typename T, size_t Alignment = 4096>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) {
+    }
+
+    T *allocate(size_t n) {
+        size_t size = (n * sizeof(T) + Alignment - 1) / Alignment * Alignment;
+        return static_cast<T *>(::operator new(size, std::align_val_t(Alignment)));
+    }
+    void deallocate(T *p, size_t) {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    void construct(U *) {
+    }
+    template <typename U, typename... Args>
+    void construct(U *p, Args &&...args) {
+        ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment> &) const {
+        return true;
+    }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment> &) const {
+        return false;
+    }
+};
+
 template <typename T>
-void print(const std::vector<T> &arr) {
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+template <typename T, typename Alloc>
+void print(const std::vector<T, Alloc> &arr) {
     for (const T &elem : arr)
         std::cout << elem << ' ';
     std::cout << std::endl;
 }
 
-template <typename T>
-void fillRandomly(std::vector<T> &arr) {
+template <typename T, typename Alloc>
+void fillRandomly(std::vector<T, Alloc> &arr) {
     std::random_device rd;
     std::mt19937 mersenne(rd());
     std::uniform_real_distribution<> urd(-1.0, 1.0);
@@ -28,7 +78,36 @@ void fillRandomly(std::vector<T> &arr) {
         el = urd(mersenne);
 }
 
-bool equals(const std::vector<float> &a, const std::vector<float> &b);
+template <typename AllocA, typename AllocB>
+bool equals(const std::vector<float, AllocA> &a, const std::vector<float, AllocB> &b) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++)
+        if (std::abs(a[i] - b[i]) >= 1e-2f)
+            return false;
+    return true;
+}
+
+// Largest absolute difference, reported next to equals for results which are not expected to match exactly
+template <typename AllocA, typename AllocB>
+float maxError(const std::vector<float, AllocA> &a, const std::vector<float, AllocB> &b) {
+    float error = 0;
+    for (size_t i = 0; i < std::min(a.size(), b.size()); i++)
+        error = std::max(error, std::abs(a[i] - b[i]));
+    return error;
+}
+
+/**
+ * Freivalds' check of c == a * b for row-major a (m x n), b (n x k) and c (m x k) in O(mn + nk + mk) per round:
+ * a * (b * r) is compared with c * r for a random r of +-1 entries. A wrong c passes a round with probability at
+ * most 1/2, so rounds are repeated until that drops below falsePositive. Non-finite elements of c always fail. Row
+ * i may differ by tolerance * sqrt(n) * FLT_EPSILON * (|a_i * b| + sqrt(sum_p a_ip^2 |b_p|^2)) with row 2-norms, the
+ * expected rounding error of float products, where |a_i * b| is estimated from the rounds so only a and b set it.
+ * Correct naive and Strassen products stay below a quarter of the default; at n = 1600 with inputs in [-1, 1] single
+ * elements off by 0.03 or more are detected.
+ */
+bool freivalds(const float *a, const float *b, const float *c, int m, int n, int k, double falsePositive = 1e-6,
+               double tolerance = 4);
 
 std::string status(bool ok);
 
@@ -0,0 +1,133 @@
+/**
+ * Kernel gemmTiled computes c = a * b for any m, n, k with by-row layout (a is m x n, b is n x k, c is m x k).
+ * A work-group computes a TILE_M x TILE_K block of c, each work-item holds a WPT_M x WPT_K micro-tile in registers.
+ * Micro-tile elements are strided by the work-group size, so neighbouring work-items touch neighbouring columns
+ * and local memory reads are free of bank conflicts. Panels of a and b of depth TILE_N are staged in local memory
+ * with vload4 (TILE_N and TILE_K have to be multiples of 4), elements outside of the matrices are loaded as zeros
+ * and results outside of c are not stored.
+ * Local work size is (TILE_K / WPT_K, TILE_M / WPT_M), global work size is rounded up to whole tiles.
+ * The inner loop over a panel carries #pragma unroll UNROLL (TILE_N has to be a multiple of UNROLL).
+ * With STORAGE_HALF or STORAGE_BF16 a and b are stored as 16-bit fp16 or bfloat16 and converted to float on load,
+ * accumulation stays in float. fp16 goes through vload_half and bfloat16 through a bit shift, so neither needs
+ * cl_khr_fp16.
+ */
+
+#ifndef TILE_M
+#define TILE_M 64
+#endif
+#ifndef TILE_K
+#define TILE_K 64
+#endif
+#ifndef TILE_N
+#define TILE_N 16
+#endif
+#ifndef WPT_M
+#define WPT_M 4
+#endif
+#ifndef WPT_K
+#define WPT_K 4
+#endif
+#ifndef UNROLL
+#define UNROLL 1
+#endif
+
+#if defined(STORAGE_HALF)
+#define INPUT half
+#define LOAD1(P) vload_half(0, P)
+#define LOAD4(P) vload_half4(0, P)
+#elif defined(STORAGE_BF16)
+#define INPUT ushort
+#define LOAD1(P) as_float((uint)(*(P)) << 16)
+#define LOAD4(P) as_float4(convert_uint4(vload4(0, P)) << 16)
+#else
+#define INPUT float
+#define LOAD1(P) (*(P))
+#define LOAD4(P) vload4(0, P)
+#endif
+
+#define LOCAL_M (TILE_M / WPT_M)
+#define LOCAL_K (TILE_K / WPT_K)
+#define THREADS (LOCAL_M * LOCAL_K)
+
+__kernel __attribute__((reqd_work_group_size(LOCAL_K, LOCAL_M, 1)))
+void gemmTiled(__global const INPUT *a, __global const INPUT *b, __global float *c, int m, int n, int k) {
+    __local float As[TILE_N][TILE_M];
+    __local float Bs[TILE_N][TILE_K];
+
+    const int tx = get_local_id(0);
+    const int ty = get_local_id(1);
+    const int tid = ty * LOCAL_K + tx;
+    const int rowBase = get_group_id(1) * TILE_M;
+    const int colBase = get_group_id(0) * TILE_K;
+
+    float acc[WPT_M][WPT_K];
+    for (int wm = 0; wm < WPT_M; wm++)
+        for (int wk = 0; wk < WPT_K; wk++)
+            acc[wm][wk] = 0.0f;
+
+    for (int t = 0; t < n; t += TILE_N) {
+        // Panel of a: TILE_M rows of TILE_N elements, stored transposed so that the inner loop reads along rows
+        for (int l = tid; l < TILE_M * TILE_N / 4; l += THREADS) {
+            int r = l / (TILE_N / 4);
+            int q = (l % (TILE_N / 4)) * 4;
+            int row = rowBase + r;
+            int inner = t + q;
+            float4 v = (float4)(0.0f);
+            if (row < m) {
+                if (inner + 3 < n) {
+                    v = LOAD4(a + row * n + inner);
+                } else {
+                    v.x = inner < n ? LOAD1(a + row * n + inner) : 0.0f;
+                    v.y = inner + 1 < n ? LOAD1(a + row * n + inner + 1) : 0.0f;
+                    v.z = inner + 2 < n ? LOAD1(a + row * n + inner + 2) : 0.0f;
+                }
+            }
+            As[q][r] = v.x;
+            As[q + 1][r] = v.y;
+            As[q + 2][r] = v.z;
+            As[q + 3][r] = v.w;
+        }
+        // Panel of b: TILE_N rows of TILE_K elements
+        for (int l = tid; l < TILE_N * TILE_K / 4; l += THREADS) {
+            int r = l / (TILE_K / 4);
+            int q = (l % (TILE_K / 4)) * 4;
+            int inner = t + r;
+            int col = colBase + q;
+            float4 v = (float4)(0.0f);
+            if (inner < n) {
+                if (col + 3 < k) {
+                    v = LOAD4(b + inner * k + col);
+                } else {
+                    v.x = col < k ? LOAD1(b + inner * k + col) : 0.0f;
+                    v.y = col + 1 < k ? LOAD1(b + inner * k + col + 1) : 0.0f;
+                    v.z = col + 2 < k ? LOAD1(b + inner * k + col + 2) : 0.0f;
+                }
+            }
+            vstore4(v, 0, &Bs[r][q]);
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+#pragma unroll UNROLL
+        for (int p = 0; p < TILE_N; p++) {
+            float aReg[WPT_M];
+            float bReg[WPT_K];
+            for (int wm = 0; wm < WPT_M; wm++)
+                aReg[wm] = As[p][ty + wm * LOCAL_M];
+            for (int wk = 0; wk < WPT_K; wk++)
+                bReg[wk] = Bs[p][tx + wk * LOCAL_K];
+            for (int wm = 0; wm < WPT_M; wm++)
+                for (int wk = 0; wk < WPT_K; wk++)
+                    acc[wm][wk] = mad(aReg[wm], bReg[wk], acc[wm][wk]);
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    for (int wm = 0; wm < WPT_M; wm++) {
+        int row = rowBase + ty + wm * LOCAL_M;
+        for (int wk = 0; wk < WPT_K; wk++) {
+            int col = colBase + tx + wk * LOCAL_K;
+            if (row < m && col < k)
+                c[row * k + col] = acc[wm][wk];
+        }
+    }
+}
@@ -0,0 +1,135 @@
+/**
+ * Kernel gemm computes c = alpha * op(a) * op(b) + beta * c in BLAS terms with by-row layout:
+ * op(a) is m x k, op(b) is k x n, c is m x n, lda, ldb and ldc are row strides, offsets are in elements.
+ * op(x) is x or its transpose depending on TRANS_A and TRANS_B, panels are loaded along the contiguous
+ * dimension of the stored matrix in either case. With beta = 0 c is not read.
+ * Tiling follows gemmTiled in gemm.cl: a work-group computes a TILE_M x TILE_K block of c (TILE_K counts
+ * columns of c here), each work-item a WPT_M x WPT_K micro-tile; local work size is (TILE_K / WPT_K, TILE_M / WPT_M).
+ * The third NDRange dimension indexes a batch of matrices placed strideA, strideB and strideC elements apart.
+ */
+
+#ifndef REAL
+#define REAL float
+#endif
+#ifdef cl_khr_fp64
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#endif
+#ifndef TRANS_A
+#define TRANS_A 0
+#endif
+#ifndef TRANS_B
+#define TRANS_B 0
+#endif
+#ifndef TILE_M
+#define TILE_M 64
+#endif
+#ifndef TILE_K
+#define TILE_K 64
+#endif
+#ifndef TILE_N
+#define TILE_N 16
+#endif
+#ifndef WPT_M
+#define WPT_M 4
+#endif
+#ifndef WPT_K
+#define WPT_K 4
+#endif
+#ifndef UNROLL
+#define UNROLL 1
+#endif
+
+#define LOCAL_M (TILE_M / WPT_M)
+#define LOCAL_K (TILE_K / WPT_K)
+#define THREADS (LOCAL_M * LOCAL_K)
+
+__kernel __attribute__((reqd_work_group_size(LOCAL_K, LOCAL_M, 1)))
+void gemm(int m, int n, int k, REAL alpha, __global const REAL *a, int aOffset, int lda, __global const REAL *b,
+          int bOffset, int ldb, REAL beta, __global REAL *c, int cOffset, int ldc, int strideA, int strideB,
+          int strideC) {
+    __local REAL As[TILE_N][TILE_M];
+    __local REAL Bs[TILE_N][TILE_K];
+
+    const int batch = get_global_id(2);
+    a += aOffset + batch * strideA;
+    b += bOffset + batch * strideB;
+    c += cOffset + batch * strideC;
+    const int tx = get_local_id(0);
+    const int ty = get_local_id(1);
+    const int tid = ty * LOCAL_K + tx;
+    const int rowBase = get_group_id(1) * TILE_M;
+    const int colBase = get_group_id(0) * TILE_K;
+
+    REAL acc[WPT_M][WPT_K];
+    for (int wm = 0; wm < WPT_M; wm++)
+        for (int wk = 0; wk < WPT_K; wk++)
+            acc[wm][wk] = 0;
+
+    for (int t = 0; t < k; t += TILE_N) {
+        for (int l = tid; l < TILE_M * TILE_N; l += THREADS) {
+#if TRANS_A
+            // a is stored k x m, consecutive work-items read consecutive rows of op(a)
+            int r = l % TILE_M;
+            int q = l / TILE_M;
+            int row = rowBase + r;
+            int inner = t + q;
+            As[q][r] = row < m && inner < k ? a[inner * lda + row] : 0;
+#else
+            int r = l / TILE_N;
+            int q = l % TILE_N;
+            int row = rowBase + r;
+            int inner = t + q;
+            As[q][r] = row < m && inner < k ? a[row * lda + inner] : 0;
+#endif
+        }
+        for (int l = tid; l < TILE_N * TILE_K; l += THREADS) {
+#if TRANS_B
+            // b is stored n x k, consecutive work-items read consecutive elements of a row of b
+            int r = l % TILE_N;
+            int q = l / TILE_N;
+            int inner = t + r;
+            int col = colBase + q;
+            Bs[r][q] = inner < k && col < n ? b[col * ldb + inner] : 0;
+#else
+            int r = l / TILE_K;
+            int q = l % TILE_K;
+            int inner = t + r;
+            int col = colBase + q;
+            Bs[r][q] = inner < k && col < n ? b[inner * ldb + col] : 0;
+#endif
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+#pragma unroll UNROLL
+        for (int p = 0; p < TILE_N; p++) {
+            REAL aReg[WPT_M];
+            REAL bReg[WPT_K];
+            for (int wm = 0; wm < WPT_M; wm++)
+                aReg[wm] = As[p][ty + wm * LOCAL_M];
+            for (int wk = 0; wk < WPT_K; wk++)
+                bReg[wk] = Bs[p][tx + wk * LOCAL_K];
+            for (int wm = 0; wm < WPT_M; wm++)
+                for (int wk = 0; wk < WPT_K; wk++)
+                    acc[wm][wk] = mad(aReg[wm], bReg[wk], acc[wm][wk]);
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    for (int wm = 0; wm < WPT_M; wm++) {
+        int row = rowBase + ty + wm * LOCAL_M;
+        for (int wk = 0; wk < WPT_K; wk++) {
+            int col = colBase + tx + wk * LOCAL_K;
+            if (row < m && col < n)
+                c[row * ldc + col] = beta == 0 ? alpha * acc[wm][wk] : alpha * acc[wm][wk] + beta * c[row * ldc + col];
+        }
+    }
+}
+
+// c = alpha * a + beta * b for m x n views, c may be the same view as a or b
+__kernel void geam(int m, int n, REAL alpha, __global const REAL *a, int aOffset, int lda, REAL beta,
+                   __global const REAL *b, int bOffset, int ldb, __global REAL *c, int cOffset, int ldc) {
+    int col = get_global_id(0);
+    int row = get_global_id(1);
+    if (row < m && col < n)
+        c[cOffset + row * ldc + col] = alpha * a[aOffset + row * lda + col] + beta * b[bOffset + row * ldb + col];
+}
@@ -1,4 +1,6 @@
+#ifndef BLOCK_SIZE
 #define BLOCK_SIZE 16
+#endif
 
 /**
  * Kernel multiplyBlockNaive works for any m, n, k and by-row matrices layout
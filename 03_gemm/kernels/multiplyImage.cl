@@ -1,27 +1,44 @@
-#define BLOCK_SIZE 16
-
 /**
- * Kernel multiplyImage works for square matrices only
+ * Kernel multiplyImage works for any m, n, k with matrices stored in CL_RGBA / CL_FLOAT images:
+ * texel (x, y) holds elements 4x..4x+3 of row y, so a is ceil(n / 4) x m texels, b and c are ceil(k / 4) x n
+ * and ceil(k / 4) x m. Each work-item computes 4 rows of one texel column of c, every fetch returns a float4.
+ * Padding elements of the last texel in a row are zeros and the sampler clamps to a zero border,
+ * so rows and columns past the end contribute nothing.
  */
 
-__kernel void multiplyImage(__read_only image2d_t a, __read_only image2d_t b, __write_only image2d_t c, int m, int n, int k) {
-    __local float A[BLOCK_SIZE][BLOCK_SIZE];
-    __local float B[BLOCK_SIZE][BLOCK_SIZE];
-    int local_row = get_local_id(0);
-    int local_col = get_local_id(1);
-    int row = get_global_id(0);
-    int col = get_global_id(1);
-    int blocks = m / BLOCK_SIZE;
-    float s = 0;
-    for (int i = 0; i < blocks; i++) {
-        float x = read_imagef(a, (int2)(BLOCK_SIZE * i + local_row, col)).x;
-        float y = read_imagef(b, (int2)(row, BLOCK_SIZE * i + local_col)).x;
-        A[local_col][local_row] = x;
-        B[local_col][local_row] = y;
-        barrier(CLK_LOCAL_MEM_FENCE);
-        for (int j = 0; j < BLOCK_SIZE; j++)
-            s += A[local_col][j] * B[j][local_row];
-        barrier(CLK_LOCAL_MEM_FENCE);
+__constant sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP | CLK_FILTER_NEAREST;
+
+__kernel void multiplyImage(__read_only image2d_t a, __read_only image2d_t b, __write_only image2d_t c, int m, int n,
+                            int k) {
+    int col = get_global_id(0);
+    int row = get_global_id(1) * 4;
+    if (col * 4 >= k || row >= m)
+        return;
+
+    float4 c0 = (float4)(0.0f);
+    float4 c1 = (float4)(0.0f);
+    float4 c2 = (float4)(0.0f);
+    float4 c3 = (float4)(0.0f);
+    for (int i = 0; i < (n + 3) / 4; i++) {
+        float4 a0 = read_imagef(a, sampler, (int2)(i, row));
+        float4 a1 = read_imagef(a, sampler, (int2)(i, row + 1));
+        float4 a2 = read_imagef(a, sampler, (int2)(i, row + 2));
+        float4 a3 = read_imagef(a, sampler, (int2)(i, row + 3));
+        float4 b0 = read_imagef(b, sampler, (int2)(col, 4 * i));
+        float4 b1 = read_imagef(b, sampler, (int2)(col, 4 * i + 1));
+        float4 b2 = read_imagef(b, sampler, (int2)(col, 4 * i + 2));
+        float4 b3 = read_imagef(b, sampler, (int2)(col, 4 * i + 3));
+        c0 += a0.x * b0 + a0.y * b1 + a0.z * b2 + a0.w * b3;
+        c1 += a1.x * b0 + a1.y * b1 + a1.z * b2 + a1.w * b3;
+        c2 += a2.x * b0 + a2.y * b1 + a2.z * b2 + a2.w * b3;
+        c3 += a3.x * b0 + a3.y * b1 + a3.z * b2 + a3.w * b3;
     }
-    write_imagef(c, (int2)(row, col), s);
+
+    write_imagef(c, (int2)(col, row), c0);
+    if (row + 1 < m)
+        write_imagef(c, (int2)(col, row + 1), c1);
+    if (row + 2 < m)
+        write_imagef(c, (int2)(col, row + 2), c2);
+    if (row + 3 < m)
+        write_imagef(c, (int2)(col, row + 3), c3);
 }
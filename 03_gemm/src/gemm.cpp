@@ -0,0 +1,247 @@
+#include "gemm.hpp"
+
+#include <algorithm>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <omp.h>
+
+#include "programCache.hpp"
+#include "tuner.hpp"
+
+#define SAFE(X) (static_cast<size_t>(X))
+
+namespace omp {
+
+/**
+ * Row of c is computed in acc as a row of op(a) times op(b): rows of b are streamed for NoTrans,
+ * for Trans a row of c is a set of dot products with rows of b
+ */
+template <typename T>
+static void gemmRow(Op transA, Op transB, int row, int n, int k, T alpha, const T *a, int lda, const T *b, int ldb,
+                    T beta, T *c, int ldc, std::vector<T> &acc) {
+    std::fill(acc.begin(), acc.end(), T(0));
+    for (int i = 0; i < k; i++) {
+        T x = transA == Op::Trans ? a[SAFE(i) * lda + row] : a[SAFE(row) * lda + i];
+        if (transB == Op::NoTrans) {
+            const T *bRow = b + SAFE(i) * ldb;
+#pragma omp simd
+            for (int col = 0; col < n; col++)
+                acc[col] += x * bRow[col];
+        } else {
+            for (int col = 0; col < n; col++)
+                acc[col] += x * b[SAFE(col) * ldb + i];
+        }
+    }
+    T *cRow = c + SAFE(row) * ldc;
+    for (int col = 0; col < n; col++)
+        cRow[col] = beta == T(0) ? alpha * acc[col] : alpha * acc[col] + beta * cRow[col];
+}
+
+template <typename T>
+static void gemm(Op transA, Op transB, int m, int n, int k, T alpha, const T *a, int lda, const T *b, int ldb, T beta,
+                 T *c, int ldc) {
+#pragma omp parallel
+    {
+        std::vector<T> acc(SAFE(n));
+#pragma omp for schedule(static)
+        for (int row = 0; row < m; row++)
+            gemmRow(transA, transB, row, n, k, alpha, a, lda, b, ldb, beta, c, ldc, acc);
+    }
+}
+
+void sgemm(Op transA, Op transB, int m, int n, int k, float alpha, const float *a, int lda, const float *b, int ldb,
+           float beta, float *c, int ldc) {
+    gemm(transA, transB, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+void dgemm(Op transA, Op transB, int m, int n, int k, double alpha, const double *a, int lda, const double *b,
+           int ldb, double beta, double *c, int ldc) {
+    gemm(transA, transB, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+// Rows of all matrices of the batch are split between threads, so small matrices still load every thread
+void sgemmBatched(Op transA, Op transB, int m, int n, int k, float alpha, const float *const *a, int lda,
+                  const float *const *b, int ldb, float beta, float *const *c, int ldc, int batch) {
+#pragma omp parallel
+    {
+        std::vector<float> acc(SAFE(n));
+#pragma omp for collapse(2) schedule(static)
+        for (int i = 0; i < batch; i++)
+            for (int row = 0; row < m; row++)
+                gemmRow(transA, transB, row, n, k, alpha, a[i], lda, b[i], ldb, beta, c[i], ldc, acc);
+    }
+}
+
+void sgemmStridedBatched(Op transA, Op transB, int m, int n, int k, float alpha, const float *a, int lda, int strideA,
+                         const float *b, int ldb, int strideB, float beta, float *c, int ldc, int strideC, int batch) {
+#pragma omp parallel
+    {
+        std::vector<float> acc(SAFE(n));
+#pragma omp for collapse(2) schedule(static)
+        for (int i = 0; i < batch; i++)
+            for (int row = 0; row < m; row++)
+                gemmRow(transA, transB, row, n, k, alpha, a + SAFE(i) * strideA, lda, b + SAFE(i) * strideB, ldb, beta,
+                        c + SAFE(i) * strideC, ldc, acc);
+    }
+}
+
+} // namespace omp
+
+namespace ocl {
+
+// Elements spanned by a stored rows x cols matrix with row stride ld
+static size_t span(int rows, int cols, int ld) {
+    return rows > 0 && cols > 0 ? SAFE(rows - 1) * ld + cols : 0;
+}
+
+// Elements spanned by a batch of stored matrices placed stride elements apart
+static size_t span(int rows, int cols, int ld, int stride, int batch) {
+    size_t single = span(rows, cols, ld);
+    return single > 0 && batch > 0 ? SAFE(batch - 1) * stride + single : 0;
+}
+
+/**
+ * One program per precision and pair of transposes, tile parameters are the tuned ones of gemmTiled
+ * for the device (float, no transposes), with shallower panels if wider elements exceed local memory.
+ * The whole batch is uploaded at once and runs in a single NDRange.
+ */
+template <typename T>
+static void gemmStridedBatched(Op transA, Op transB, int m, int n, int k, T alpha, const T *a, int lda, int strideA,
+                               const T *b, int ldb, int strideB, T beta, T *c, int ldc, int strideC, int batch,
+                               cl_device_id deviceId, float *elapsed) {
+    if (m <= 0 || n <= 0 || batch <= 0)
+        return;
+    Tuner::GemmConfig config = Tuner::gemmConfig(deviceId, m, k, n);
+    // Tiles are tuned with float panels, wider elements may need shallower panels to fit local memory
+    cl_ulong localMem = 0;
+    clGetDeviceInfo(deviceId, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(cl_ulong), &localMem, nullptr);
+    while (config.tileN > 4 && SAFE(config.tileM + config.tileK) * config.tileN * sizeof(T) > localMem)
+        config.tileN /= 2;
+    config.unroll = std::min(config.unroll, config.tileN);
+    std::string options = config.options() + (std::is_same<T, double>::value ? " -DREAL=double" : " -DREAL=float") +
+                          (transA == Op::Trans ? " -DTRANS_A=1" : " -DTRANS_A=0") +
+                          (transB == Op::Trans ? " -DTRANS_B=1" : " -DTRANS_B=0");
+
+    cl_context context = clCreateContext(nullptr, 1, &deviceId, nullptr, nullptr, nullptr);
+    cl_command_queue queue = clCreateCommandQueue(context, deviceId, 0, nullptr);
+    cl_program program = ProgramCache::build(context, deviceId, "gemmBlas.cl", options);
+    cl_kernel kernel = clCreateKernel(program, "gemm", nullptr);
+
+    // At least one element per buffer so that k = 0 still has valid arguments
+    size_t aSize = transA == Op::Trans ? span(k, m, lda, strideA, batch) : span(m, k, lda, strideA, batch);
+    size_t bSize = transB == Op::Trans ? span(n, k, ldb, strideB, batch) : span(k, n, ldb, strideB, batch);
+    aSize = std::max<size_t>(1u, aSize) * sizeof(T);
+    bSize = std::max<size_t>(1u, bSize) * sizeof(T);
+    size_t cSize = span(m, n, ldc, strideC, batch) * sizeof(T);
+    cl_mem aMem = clCreateBuffer(context, CL_MEM_READ_ONLY, aSize, nullptr, nullptr);
+    cl_mem bMem = clCreateBuffer(context, CL_MEM_READ_ONLY, bSize, nullptr, nullptr);
+    cl_mem cMem = clCreateBuffer(context, CL_MEM_READ_WRITE, cSize, nullptr, nullptr);
+    if (k > 0) {
+        clEnqueueWriteBuffer(queue, aMem, CL_FALSE, 0, aSize, a, 0, nullptr, nullptr);
+        clEnqueueWriteBuffer(queue, bMem, CL_FALSE, 0, bSize, b, 0, nullptr, nullptr);
+    }
+    // Elements between ldc strides are written back unchanged, so c is uploaded even with beta = 0
+    clEnqueueWriteBuffer(queue, cMem, CL_TRUE, 0, cSize, c, 0, nullptr, nullptr);
+
+    int zero = 0;
+    clSetKernelArg(kernel, 0, sizeof(int), &m);
+    clSetKernelArg(kernel, 1, sizeof(int), &n);
+    clSetKernelArg(kernel, 2, sizeof(int), &k);
+    clSetKernelArg(kernel, 3, sizeof(T), &alpha);
+    clSetKernelArg(kernel, 4, sizeof(cl_mem), &aMem);
+    clSetKernelArg(kernel, 5, sizeof(int), &zero);
+    clSetKernelArg(kernel, 6, sizeof(int), &lda);
+    clSetKernelArg(kernel, 7, sizeof(cl_mem), &bMem);
+    clSetKernelArg(kernel, 8, sizeof(int), &zero);
+    clSetKernelArg(kernel, 9, sizeof(int), &ldb);
+    clSetKernelArg(kernel, 10, sizeof(T), &beta);
+    clSetKernelArg(kernel, 11, sizeof(cl_mem), &cMem);
+    clSetKernelArg(kernel, 12, sizeof(int), &zero);
+    clSetKernelArg(kernel, 13, sizeof(int), &ldc);
+    clSetKernelArg(kernel, 14, sizeof(int), &strideA);
+    clSetKernelArg(kernel, 15, sizeof(int), &strideB);
+    clSetKernelArg(kernel, 16, sizeof(int), &strideC);
+
+    size_t globalWorkSize[] = {(SAFE(n) + config.tileK - 1) / config.tileK * config.localK(),
+                               (SAFE(m) + config.tileM - 1) / config.tileM * config.localM(), SAFE(batch)};
+    size_t localWorkSize[] = {config.localK(), config.localM(), 1u};
+    float begin = omp_get_wtime();
+    clEnqueueNDRangeKernel(queue, kernel, 3, nullptr, globalWorkSize, localWorkSize, 0, nullptr, nullptr);
+    clFinish(queue);
+    float end = omp_get_wtime();
+    if (elapsed != nullptr)
+        *elapsed = end - begin;
+    clEnqueueReadBuffer(queue, cMem, CL_TRUE, 0, cSize, c, 0, nullptr, nullptr);
+
+    clReleaseMemObject(aMem);
+    clReleaseMemObject(bMem);
+    clReleaseMemObject(cMem);
+    clReleaseKernel(kernel);
+    clReleaseProgram(program);
+    clReleaseCommandQueue(queue);
+    clReleaseContext(context);
+}
+
+template <typename T>
+static void gemm(Op transA, Op transB, int m, int n, int k, T alpha, const T *a, int lda, const T *b, int ldb, T beta,
+                 T *c, int ldc, cl_device_id deviceId, float *elapsed) {
+    gemmStridedBatched(transA, transB, m, n, k, alpha, a, lda, 0, b, ldb, 0, beta, c, ldc, 0, 1, deviceId, elapsed);
+}
+
+void sgemm(Op transA, Op transB, int m, int n, int k, float alpha, const float *a, int lda, const float *b, int ldb,
+           float beta, float *c, int ldc, cl_device_id deviceId, float *elapsed) {
+    gemm(transA, transB, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, deviceId, elapsed);
+}
+
+// Devices without double precision support run the host version
+void dgemm(Op transA, Op transB, int m, int n, int k, double alpha, const double *a, int lda, const double *b,
+           int ldb, double beta, double *c, int ldc, cl_device_id deviceId, float *elapsed) {
+    cl_device_fp_config doubleConfig = 0;
+    clGetDeviceInfo(deviceId, CL_DEVICE_DOUBLE_FP_CONFIG, sizeof(doubleConfig), &doubleConfig, nullptr);
+    if (doubleConfig == 0) {
+        float begin = omp_get_wtime();
+        omp::dgemm(transA, transB, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+        float end = omp_get_wtime();
+        if (elapsed != nullptr)
+            *elapsed = end - begin;
+        return;
+    }
+    gemm(transA, transB, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, deviceId, elapsed);
+}
+
+void sgemmStridedBatched(Op transA, Op transB, int m, int n, int k, float alpha, const float *a, int lda, int strideA,
+                         const float *b, int ldb, int strideB, float beta, float *c, int ldc, int strideC, int batch,
+                         cl_device_id deviceId, float *elapsed) {
+    gemmStridedBatched(transA, transB, m, n, k, alpha, a, lda, strideA, b, ldb, strideB, beta, c, ldc, strideC, batch,
+                       deviceId, elapsed);
+}
+
+// Matrices of the batch are gathered one after another into contiguous arrays and c is scattered back
+void sgemmBatched(Op transA, Op transB, int m, int n, int k, float alpha, const float *const *a, int lda,
+                  const float *const *b, int ldb, float beta, float *const *c, int ldc, int batch,
+                  cl_device_id deviceId, float *elapsed) {
+    if (batch <= 0)
+        return;
+    size_t aSpan = transA == Op::Trans ? span(k, m, lda) : span(m, k, lda);
+    size_t bSpan = transB == Op::Trans ? span(n, k, ldb) : span(k, n, ldb);
+    size_t cSpan = span(m, n, ldc);
+    std::vector<float> aPacked(aSpan * batch);
+    std::vector<float> bPacked(bSpan * batch);
+    std::vector<float> cPacked(cSpan * batch);
+#pragma omp parallel for
+    for (int i = 0; i < batch; i++) {
+        std::copy(a[i], a[i] + aSpan, aPacked.begin() + aSpan * i);
+        std::copy(b[i], b[i] + bSpan, bPacked.begin() + bSpan * i);
+        std::copy(c[i], c[i] + cSpan, cPacked.begin() + cSpan * i);
+    }
+    gemmStridedBatched(transA, transB, m, n, k, alpha, aPacked.data(), lda, static_cast<int>(aSpan), bPacked.data(),
+                       ldb, static_cast<int>(bSpan), beta, cPacked.data(), ldc, static_cast<int>(cSpan), batch,
+                       deviceId, elapsed);
+#pragma omp parallel for
+    for (int i = 0; i < batch; i++)
+        std::copy(cPacked.begin() + cSpan * i, cPacked.begin() + cSpan * (i + 1), c[i]);
+}
+
+} // namespace ocl
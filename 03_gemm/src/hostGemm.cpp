@@ -0,0 +1,193 @@
+#include "hostGemm.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+#include <omp.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_X86
+#endif
+
+#include "utils.hpp"
+
+#define SAFE(X) (static_cast<size_t>(X))
+
+namespace HostGemm {
+
+// Rows of the micro-tile, block sizes are multiples of the micro-tile: MC x KC panel of a fits L2, KC x NC of b fits L3
+static constexpr int MR = 6;
+static constexpr int MC = 144;
+static constexpr int KC = 256;
+static constexpr int NC = 3072;
+
+/**
+ * Micro-kernel adds the product of packed panels to the MR x nr block of c (row stride ldc):
+ * a panel holds MR elements per step of depth, b panel holds nr elements per step
+ */
+using MicroKernel = void (*)(int kc, const float *a, const float *b, float *c, int ldc);
+
+struct Kernel {
+    MicroKernel run;
+    int nr;
+    const char *name;
+};
+
+static void microKernelGeneric(int kc, const float *a, const float *b, float *c, int ldc) {
+    constexpr int NR = 8;
+    float acc[MR][NR] = {};
+    for (int p = 0; p < kc; p++, a += MR, b += NR)
+        for (int i = 0; i < MR; i++)
+            for (int j = 0; j < NR; j++)
+                acc[i][j] += a[i] * b[j];
+    for (int i = 0; i < MR; i++)
+        for (int j = 0; j < NR; j++)
+            c[SAFE(i) * ldc + j] += acc[i][j];
+}
+
+#ifdef SIMD_X86
+
+// 6 x 16 tile in 12 ymm accumulators
+__attribute__((target("avx2,fma"))) static void microKernelAvx2(int kc, const float *a, const float *b, float *c,
+                                                                int ldc) {
+    __m256 acc[MR][2];
+    for (int i = 0; i < MR; i++)
+        acc[i][0] = acc[i][1] = _mm256_setzero_ps();
+    for (int p = 0; p < kc; p++, a += MR, b += 16) {
+        __m256 b0 = _mm256_load_ps(b);
+        __m256 b1 = _mm256_load_ps(b + 8);
+        for (int i = 0; i < MR; i++) {
+            __m256 ai = _mm256_broadcast_ss(a + i);
+            acc[i][0] = _mm256_fmadd_ps(ai, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_ps(ai, b1, acc[i][1]);
+        }
+    }
+    for (int i = 0; i < MR; i++) {
+        float *row = c + SAFE(i) * ldc;
+        _mm256_storeu_ps(row, _mm256_add_ps(_mm256_loadu_ps(row), acc[i][0]));
+        _mm256_storeu_ps(row + 8, _mm256_add_ps(_mm256_loadu_ps(row + 8), acc[i][1]));
+    }
+}
+
+// 6 x 32 tile in 12 zmm accumulators
+__attribute__((target("avx512f"))) static void microKernelAvx512(int kc, const float *a, const float *b, float *c,
+                                                                 int ldc) {
+    __m512 acc[MR][2];
+    for (int i = 0; i < MR; i++)
+        acc[i][0] = acc[i][1] = _mm512_setzero_ps();
+    for (int p = 0; p < kc; p++, a += MR, b += 32) {
+        __m512 b0 = _mm512_load_ps(b);
+        __m512 b1 = _mm512_load_ps(b + 16);
+        for (int i = 0; i < MR; i++) {
+            __m512 ai = _mm512_set1_ps(a[i]);
+            acc[i][0] = _mm512_fmadd_ps(ai, b0, acc[i][0]);
+            acc[i][1] = _mm512_fmadd_ps(ai, b1, acc[i][1]);
+        }
+    }
+    for (int i = 0; i < MR; i++) {
+        float *row = c + SAFE(i) * ldc;
+        _mm512_storeu_ps(row, _mm512_add_ps(_mm512_loadu_ps(row), acc[i][0]));
+        _mm512_storeu_ps(row + 16, _mm512_add_ps(_mm512_loadu_ps(row + 16), acc[i][1]));
+    }
+}
+
+#endif
+
+static Kernel selectKernel() {
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return {microKernelAvx512, 32, "AVX-512"};
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return {microKernelAvx2, 16, "AVX2+FMA"};
+#endif
+    return {microKernelGeneric, 8, "generic"};
+}
+
+static const Kernel &kernel() {
+    static const Kernel selected = selectKernel();
+    return selected;
+}
+
+const char *isaName() {
+    return kernel().name;
+}
+
+// Packs rows [0, mc) x depth [0, kc) of a into MR-row panels, rows past mc are zeros
+static void packA(int mc, int kc, const float *a, int lda, float *packed) {
+#pragma omp for schedule(static)
+    for (int ir = 0; ir < mc; ir += MR) {
+        float *panel = packed + SAFE(ir) * kc;
+        for (int p = 0; p < kc; p++)
+            for (int i = 0; i < MR; i++)
+                panel[p * MR + i] = ir + i < mc ? a[SAFE(ir + i) * lda + p] : 0.f;
+    }
+}
+
+// Packs depth [0, kc) x columns [0, nc) of b into nr-column panels, columns past nc are zeros
+static void packB(int kc, int nc, int nr, const float *b, int ldb, float *packed) {
+#pragma omp for schedule(static)
+    for (int jr = 0; jr < nc; jr += nr) {
+        float *panel = packed + SAFE(jr) * kc;
+        int cols = std::min(nr, nc - jr);
+        for (int p = 0; p < kc; p++) {
+            const float *row = b + SAFE(p) * ldb + jr;
+            for (int j = 0; j < cols; j++)
+                panel[p * nr + j] = row[j];
+            for (int j = cols; j < nr; j++)
+                panel[p * nr + j] = 0.f;
+        }
+    }
+}
+
+void multiply(const float *a, const float *b, float *c, int m, int n, int k) {
+    const Kernel &micro = kernel();
+    const int nr = micro.nr;
+    const int nc = std::min(NC, (k + nr - 1) / nr * nr);
+    Utils::AlignedVector<float> aPacked(SAFE(MC) * KC);
+    Utils::AlignedVector<float> bPacked(SAFE(nc) * KC);
+
+#pragma omp parallel
+    {
+        // Edge tiles are computed into a zeroed buffer and then added to the valid part of c
+        Utils::AlignedVector<float> edge(SAFE(MR) * nr);
+
+#pragma omp for schedule(static)
+        for (int row = 0; row < m; row++)
+            std::fill(c + SAFE(row) * k, c + SAFE(row + 1) * k, 0.f);
+
+        for (int jc = 0; jc < k; jc += nc) {
+            int ncCur = std::min(nc, k - jc);
+            for (int pc = 0; pc < n; pc += KC) {
+                int kcCur = std::min(KC, n - pc);
+                packB(kcCur, ncCur, nr, b + SAFE(pc) * k + jc, k, bPacked.data());
+                for (int ic = 0; ic < m; ic += MC) {
+                    int mcCur = std::min(MC, m - ic);
+                    packA(mcCur, kcCur, a + SAFE(ic) * n + pc, n, aPacked.data());
+#pragma omp for schedule(static)
+                    for (int jr = 0; jr < ncCur; jr += nr) {
+                        const float *bPanel = bPacked.data() + SAFE(jr) * kcCur;
+                        int cols = std::min(nr, ncCur - jr);
+                        for (int ir = 0; ir < mcCur; ir += MR) {
+                            const float *aPanel = aPacked.data() + SAFE(ir) * kcCur;
+                            int rows = std::min(MR, mcCur - ir);
+                            float *cBlock = c + SAFE(ic + ir) * k + jc + jr;
+                            if (rows == MR && cols == nr) {
+                                micro.run(kcCur, aPanel, bPanel, cBlock, k);
+                                continue;
+                            }
+                            std::fill(edge.begin(), edge.end(), 0.f);
+                            micro.run(kcCur, aPanel, bPanel, edge.data(), nr);
+                            for (int i = 0; i < rows; i++)
+                                for (int j = 0; j < cols; j++)
+                                    cBlock[SAFE(i) * k + j] += edge[SAFE(i) * nr + j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace HostGemm
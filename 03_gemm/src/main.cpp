@@ -2,21 +2,29 @@
 #define KERNELS_DIR
 #endif
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include <CL/cl.h>
 #include <omp.h>
 
+#include "gemm.hpp"
+#include "hostGemm.hpp"
 #include "multiply.hpp"
+#include "programCache.hpp"
+#include "tuner.hpp"
 #include "utils.hpp"
 
-int main() {
+int main(int argc, char **argv) {
 #pragma omp parallel
     {
 #pragma omp single
         std::cout << "OpenMP: " << omp_get_num_threads() << " threads" << std::endl;
     }
+    std::cout << "Host GEMM micro-kernel: " << HostGemm::isaName() << std::endl;
 
     cl_uint platformCount = 0;
     clGetPlatformIDs(0, nullptr, &platformCount);
@@ -38,41 +46,75 @@ int main() {
     constexpr int n = 1600;
     constexpr int k = 1600;
 
-    std::vector<float> a(m * n);
-    std::vector<float> b(n * k);
+    // With --tune the tiled kernel is tuned for both devices first, normal runs use the stored configurations.
+    // The O(n^3) sequential multiply only runs with --sequential, results are checked with Freivalds' algorithm.
+    // --check-half sweeps all float and half bit patterns through the fp16 conversions before the benchmarks.
+    bool tune = false;
+    bool sequential = false;
+    bool checkHalf = false;
+    for (int i = 1; i < argc; i++) {
+        tune = tune || std::string(argv[i]) == "--tune";
+        sequential = sequential || std::string(argv[i]) == "--sequential";
+        checkHalf = checkHalf || std::string(argv[i]) == "--check-half";
+    }
+    if (checkHalf) {
+        std::cout << "------ fp16 conversions ------" << std::endl;
+        long long mismatches = Precision::checkHalf();
+        std::cout << "Against F16C: " << (mismatches < 0 ? "skipped, no F16C" : Utils::status(mismatches == 0))
+                  << std::endl;
+    }
+    if (tune) {
+        std::cout << "------ Tuning ------" << std::endl;
+        for (cl_device_id deviceId : {cpuDeviceId, gpuDeviceId}) {
+            Tuner::GemmConfig config = Tuner::tuneGemm(deviceId, m, n, k);
+            std::cout << (deviceId == cpuDeviceId ? "OpenCL CPU: " : "OpenCL GPU: ") << config.options() << ' '
+                      << config.blockOptions() << std::endl;
+        }
+    }
+
+    Utils::AlignedVector<float> a(m * n);
+    Utils::AlignedVector<float> b(n * k);
     std::vector<float> cTarget(m * k);
     Utils::fillRandomly(a);
     Utils::fillRandomly(b);
     std::cout << std::defaultfloat << std::setprecision(6);
 
-    {
+    auto verify = [&](const auto &c) {
+        return Utils::freivalds(a.data(), b.data(), c.data(), m, n, k);
+    };
+
+    if (sequential) {
+        std::vector<float> c(m * k);
         float begin = omp_get_wtime();
-        multiply(a.data(), b.data(), cTarget.data(), m, n, k);
+        multiply(a.data(), b.data(), c.data(), m, n, k);
         float end = omp_get_wtime();
-        std::cout << "Sequential: " << (end - begin) << std::endl;
+        std::cout << "Sequential: " << (end - begin) << ' ' << Utils::status(verify(c)) << std::endl;
     }
     std::cout << "------ Classic ------" << std::endl;
     {
-        std::vector<float> c(m * k);
+        // Verified result of the host GEMM is the reference for max error reports below
         float begin = omp_get_wtime();
-        omp::multiply(a.data(), b.data(), c.data(), m, n, k);
+        omp::multiply(a.data(), b.data(), cTarget.data(), m, n, k);
         float end = omp_get_wtime();
-        std::cout << "OpenMP: " << (end - begin) << ' ';
-        std::cout << Utils::status(Utils::equals(c, cTarget)) << std::endl;
+        std::cout << "OpenMP: " << (end - begin) << ' ' << 2e-9 * m * n * k / (end - begin) << " GFLOP/s ";
+        begin = omp_get_wtime();
+        bool ok = verify(cTarget);
+        end = omp_get_wtime();
+        std::cout << Utils::status(ok) << ", check " << (end - begin) << std::endl;
     }
     {
         std::vector<float> c(m * k, 0);
         float elapsed = 0;
         ocl::multiply(a.data(), b.data(), c.data(), m, n, k, cpuDeviceId, &elapsed);
         std::cout << "OpenCL CPU: " << elapsed << ' ';
-        std::cout << Utils::status(Utils::equals(c, cTarget)) << std::endl;
+        std::cout << Utils::status(verify(c)) << std::endl;
     }
     {
         std::vector<float> c(m * k, 0);
         float elapsed = 0;
         ocl::multiply(a.data(), b.data(), c.data(), m, n, k, gpuDeviceId, &elapsed);
         std::cout << "OpenCL GPU: " << elapsed << ' ';
-        std::cout << Utils::status(Utils::equals(c, cTarget)) << std::endl;
+        std::cout << Utils::status(verify(c)) << std::endl;
     }
     std::cout << "------ Optimized ------" << std::endl;
     {
@@ -80,14 +122,187 @@ int main() {
         float elapsed = 0;
         ocl::multiplyBlock(a.data(), b.data(), c.data(), m, n, k, cpuDeviceId, &elapsed);
         std::cout << "OpenCL CPU: " << elapsed << ' ';
-        std::cout << Utils::status(Utils::equals(c, cTarget)) << std::endl;
+        std::cout << Utils::status(verify(c)) << std::endl;
     }
     {
         std::vector<float> c(m * k, 0);
         float elapsed = 0;
         ocl::multiplyBlock(a.data(), b.data(), c.data(), m, n, k, gpuDeviceId, &elapsed);
         std::cout << "OpenCL GPU: " << elapsed << ' ';
-        std::cout << Utils::status(Utils::equals(c, cTarget)) << std::endl;
+        std::cout << Utils::status(verify(c)) << std::endl;
+    }
+    std::cout << "------ Register-tiled ------" << std::endl;
+    for (cl_device_id deviceId : {cpuDeviceId, gpuDeviceId}) {
+        std::vector<float> c(m * k, 0);
+        float blockElapsed = 0;
+        ocl::multiplyBlock(a.data(), b.data(), c.data(), m, n, k, deviceId, &blockElapsed);
+        float elapsed = 0;
+        ocl::multiplyTiled(a.data(), b.data(), c.data(), m, n, k, deviceId, &elapsed);
+        double gflops = 2e-9 * m * n * k;
+        std::cout << (deviceId == cpuDeviceId ? "OpenCL CPU: " : "OpenCL GPU: ") << elapsed << ' '
+                  << gflops / elapsed << " GFLOP/s (block " << gflops / blockElapsed << " GFLOP/s) ";
+        std::cout << Utils::status(verify(c)) << std::endl;
+    }
+    {
+        // Shapes which are not multiples of tiles, multiplyBlock dispatches them to the tiled kernel
+        constexpr int mOdd = 333;
+        constexpr int nOdd = 517;
+        constexpr int kOdd = 129;
+        std::vector<float> aOdd(mOdd * nOdd);
+        std::vector<float> bOdd(nOdd * kOdd);
+        Utils::fillRandomly(aOdd);
+        Utils::fillRandomly(bOdd);
+        std::vector<float> c(mOdd * kOdd, 0);
+        ocl::multiplyBlock(aOdd.data(), bOdd.data(), c.data(), mOdd, nOdd, kOdd, gpuDeviceId, nullptr);
+        std::cout << "OpenCL GPU " << mOdd << 'x' << nOdd << 'x' << kOdd << ": ";
+        bool ok = Utils::freivalds(aOdd.data(), bOdd.data(), c.data(), mOdd, nOdd, kOdd);
+        std::cout << Utils::status(ok) << std::endl;
+    }
+    std::cout << "------ BLAS interface (c = 2 * op(a) * op(b) + 0.5 * c) ------" << std::endl;
+    for (Op transA : {Op::NoTrans, Op::Trans}) {
+        for (Op transB : {Op::NoTrans, Op::Trans}) {
+            // a and b are used in place as stored, op() only changes how they are read
+            std::vector<float> cInit(m * k);
+            Utils::fillRandomly(cInit);
+            std::vector<float> cReference = cInit;
+            omp::sgemm(transA, transB, m, k, n, 2.f, a.data(), n, b.data(), k, 0.5f, cReference.data(), k);
+            std::vector<float> c = cInit;
+            float elapsed = 0;
+            ocl::sgemm(transA, transB, m, k, n, 2.f, a.data(), n, b.data(), k, 0.5f, c.data(), k, gpuDeviceId,
+                       &elapsed);
+            std::cout << "OpenCL GPU " << (transA == Op::Trans ? 'T' : 'N') << (transB == Op::Trans ? 'T' : 'N')
+                      << ": " << elapsed << ' ';
+            std::cout << Utils::status(Utils::equals(c, cReference)) << std::endl;
+        }
+    }
+    {
+        // Same kernel built for double, the tolerance is relative to the reference element
+        std::vector<double> aDouble(a.begin(), a.end());
+        std::vector<double> bDouble(b.begin(), b.end());
+        for (Op trans : {Op::NoTrans, Op::Trans}) {
+            std::vector<double> cInit(m * k);
+            Utils::fillRandomly(cInit);
+            std::vector<double> cReference = cInit;
+            omp::dgemm(trans, trans, m, k, n, 2., aDouble.data(), n, bDouble.data(), k, 0.5, cReference.data(), k);
+            std::vector<double> c = cInit;
+            float elapsed = 0;
+            ocl::dgemm(trans, trans, m, k, n, 2., aDouble.data(), n, bDouble.data(), k, 0.5, c.data(), k, gpuDeviceId,
+                       &elapsed);
+            bool ok = true;
+            for (size_t i = 0; i < c.size(); i++)
+                ok = ok && std::abs(c[i] - cReference[i]) <= 1e-9 * std::max(1.0, std::abs(cReference[i]));
+            std::cout << "OpenCL GPU double " << (trans == Op::Trans ? "TT" : "NN") << ": " << elapsed << ' '
+                      << Utils::status(ok) << std::endl;
+        }
+    }
+    std::cout << "------ Batched (count, size: loop of calls, strided GPU, pointer-array GPU, OpenMP) ------";
+    std::cout << std::endl;
+    for (int count : {100, 1000, 2000}) {
+        for (int size : {32, 64, 128}) {
+            const int stride = size * size;
+            std::vector<float> aBatch(static_cast<size_t>(count) * stride);
+            std::vector<float> bBatch(static_cast<size_t>(count) * stride);
+            Utils::fillRandomly(aBatch);
+            Utils::fillRandomly(bBatch);
+            std::vector<float> cReference(static_cast<size_t>(count) * stride, 0);
+            std::cout << count << ", " << size << ": ";
+
+            double begin = omp_get_wtime();
+            omp::sgemmStridedBatched(Op::NoTrans, Op::NoTrans, size, size, size, 1.f, aBatch.data(), size, stride,
+                                     bBatch.data(), size, stride, 0.f, cReference.data(), size, stride, count);
+            double ompTime = omp_get_wtime() - begin;
+
+            // Separate calls pay for a context, a program lookup and buffers each, so only small batches are looped
+            if (count <= 100) {
+                std::vector<float> c(cReference.size(), 0);
+                begin = omp_get_wtime();
+                for (int i = 0; i < count; i++)
+                    ocl::sgemm(Op::NoTrans, Op::NoTrans, size, size, size, 1.f, aBatch.data() + i * stride, size,
+                               bBatch.data() + i * stride, size, 0.f, c.data() + i * stride, size, gpuDeviceId);
+                std::cout << (omp_get_wtime() - begin) << ' ' << Utils::status(Utils::equals(c, cReference)) << ", ";
+            } else {
+                std::cout << "- , ";
+            }
+
+            std::vector<float> c(cReference.size(), 0);
+            begin = omp_get_wtime();
+            ocl::sgemmStridedBatched(Op::NoTrans, Op::NoTrans, size, size, size, 1.f, aBatch.data(), size, stride,
+                                     bBatch.data(), size, stride, 0.f, c.data(), size, stride, count, gpuDeviceId);
+            std::cout << (omp_get_wtime() - begin) << ' ' << Utils::status(Utils::equals(c, cReference)) << ", ";
+
+            std::vector<const float *> aPointers(count);
+            std::vector<const float *> bPointers(count);
+            std::vector<float *> cPointers(count);
+            std::fill(c.begin(), c.end(), 0.f);
+            for (int i = 0; i < count; i++) {
+                aPointers[i] = aBatch.data() + i * stride;
+                bPointers[i] = bBatch.data() + i * stride;
+                cPointers[i] = c.data() + i * stride;
+            }
+            begin = omp_get_wtime();
+            ocl::sgemmBatched(Op::NoTrans, Op::NoTrans, size, size, size, 1.f, aPointers.data(), size,
+                              bPointers.data(), size, 0.f, cPointers.data(), size, count, gpuDeviceId);
+            std::cout << (omp_get_wtime() - begin) << ' ' << Utils::status(Utils::equals(c, cReference)) << ", ";
+            std::cout << ompTime << std::endl;
+        }
+    }
+    std::cout << "------ Mixed precision (16-bit storage, float accumulation) ------" << std::endl;
+    for (cl_device_id deviceId : {cpuDeviceId, gpuDeviceId}) {
+        std::vector<float> c(m * k, 0);
+        float floatElapsed = 0;
+        ocl::multiplyTiled(a.data(), b.data(), c.data(), m, n, k, deviceId, &floatElapsed);
+        size_t floatBytes = (static_cast<size_t>(m) * n + static_cast<size_t>(n) * k + static_cast<size_t>(m) * k) *
+                            sizeof(float);
+        for (Precision::Storage storage : {Precision::Storage::Half, Precision::Storage::BFloat16}) {
+            float elapsed = 0;
+            size_t bytes = 0;
+            ocl::multiplyMixed(a.data(), b.data(), c.data(), m, n, k, storage, deviceId, &elapsed, &bytes);
+            std::cout << (deviceId == cpuDeviceId ? "OpenCL CPU " : "OpenCL GPU ")
+                      << (storage == Precision::Storage::Half ? "fp16: " : "bf16: ") << elapsed << ", speedup "
+                      << floatElapsed / elapsed << ", bytes " << bytes << " of " << floatBytes << ", max error "
+                      << Utils::maxError(c, cTarget) << std::endl;
+        }
+    }
+    std::cout << "------ Strassen-Winograd (depth: time, block time, max error) ------" << std::endl;
+    for (cl_device_id deviceId : {cpuDeviceId, gpuDeviceId}) {
+        std::vector<float> c(m * k, 0);
+        float blockElapsed = 0;
+        ocl::multiplyBlock(a.data(), b.data(), c.data(), m, n, k, deviceId, &blockElapsed);
+        for (int depth : {1, 2}) {
+            float elapsed = 0;
+            ocl::multiplyStrassen(a.data(), b.data(), c.data(), m, n, k, deviceId, &elapsed, depth, 256);
+            std::cout << (deviceId == cpuDeviceId ? "OpenCL CPU " : "OpenCL GPU ") << depth << ": " << elapsed << ' '
+                      << blockElapsed << ' ' << Utils::maxError(c, cTarget) << ' ';
+            std::cout << Utils::status(verify(c)) << std::endl;
+        }
+    }
+    std::cout << "------ Out-of-core (budget: time, bytes moved) ------" << std::endl;
+    {
+        float tiledElapsed = 0;
+        std::vector<float> c(m * k, 0);
+        ocl::multiplyTiled(a.data(), b.data(), c.data(), m, n, k, cpuDeviceId, &tiledElapsed);
+        std::cout << "OpenCL CPU in-core: " << tiledElapsed << std::endl;
+        // Tiny budgets on the CPU device force inner chunks (1 MiB) and shared full panels (8 MiB)
+        for (size_t budget : {size_t(1) << 20, size_t(8) << 20, size_t(0)}) {
+            std::fill(c.begin(), c.end(), 0.0f);
+            float elapsed = 0;
+            size_t bytes = 0;
+            ocl::multiplyOutOfCore(a.data(), b.data(), c.data(), m, n, k, cpuDeviceId, &elapsed, budget, &bytes);
+            std::cout << "OpenCL CPU " << (budget == 0 ? std::string("default") : std::to_string(budget >> 20) + " MiB")
+                      << ": " << elapsed << ' ' << bytes << ' ';
+            std::cout << Utils::status(verify(c)) << std::endl;
+        }
+    }
+    std::cout << "------ Copy vs zero-copy (full call) ------" << std::endl;
+    for (ocl::Transfer transfer : {ocl::Transfer::Copy, ocl::Transfer::ZeroCopy}) {
+        Utils::AlignedVector<float> c(m * k, 0);
+        float elapsed = 0;
+        double begin = omp_get_wtime();
+        ocl::multiplyBlock(a.data(), b.data(), c.data(), m, n, k, cpuDeviceId, &elapsed, transfer);
+        double end = omp_get_wtime();
+        std::cout << (transfer == ocl::Transfer::Copy ? "OpenCL CPU copy: " : "OpenCL CPU zero-copy: ");
+        std::cout << (end - begin) << ' ';
+        std::cout << Utils::status(verify(c)) << std::endl;
     }
     std::cout << "------ Optimized (image) ------" << std::endl;
     {
@@ -95,15 +310,35 @@ int main() {
         float elapsed = 0;
         ocl::multiplyImage(a.data(), b.data(), c.data(), m, n, k, cpuDeviceId, &elapsed);
         std::cout << "OpenCL CPU: " << elapsed << ' ';
-        std::cout << Utils::status(Utils::equals(c, cTarget)) << std::endl;
+        std::cout << Utils::status(verify(c)) << std::endl;
     }
     {
         std::vector<float> c(m * k, 0);
         float elapsed = 0;
         ocl::multiplyImage(a.data(), b.data(), c.data(), m, n, k, gpuDeviceId, &elapsed);
         std::cout << "OpenCL GPU: " << elapsed << ' ';
-        std::cout << Utils::status(Utils::equals(c, cTarget)) << std::endl;
+        std::cout << Utils::status(verify(c)) << std::endl;
     }
 
+    {
+        constexpr int mOdd = 333;
+        constexpr int nOdd = 517;
+        constexpr int kOdd = 129;
+        std::vector<float> aOdd(mOdd * nOdd);
+        std::vector<float> bOdd(nOdd * kOdd);
+        Utils::fillRandomly(aOdd);
+        Utils::fillRandomly(bOdd);
+        std::vector<float> c(mOdd * kOdd, 0);
+        ocl::multiplyImage(aOdd.data(), bOdd.data(), c.data(), mOdd, nOdd, kOdd, gpuDeviceId, nullptr);
+        std::cout << "OpenCL GPU " << mOdd << 'x' << nOdd << 'x' << kOdd << ": ";
+        bool ok = Utils::freivalds(aOdd.data(), bOdd.data(), c.data(), mOdd, nOdd, kOdd);
+        std::cout << Utils::status(ok) << std::endl;
+    }
+
+    const ProgramCache::Stats &cacheStats = ProgramCache::stats();
+    std::cout << "------ Program cache ------" << std::endl;
+    std::cout << cacheStats.hits << " hits, " << cacheStats.misses << " misses, build time " << cacheStats.buildTime
+              << std::endl;
+
     delete[] platform;
 }
@@ -1,19 +1,28 @@
 #include "multiply.hpp"
 
+#include <algorithm>
 #include <omp.h>
 #include <string>
+#include <vector>
 
+#include "hostGemm.hpp"
+#include "programCache.hpp"
+#include "tuner.hpp"
 #include "utils.hpp"
 
 #define SAFE(X) (static_cast<size_t>(X))
 
+// Row of b is streamed for each element of a, so the reference walks all matrices along rows
 void multiply(float *a, float *b, float *c, int m, int n, int k) {
     for (int row = 0; row < m; row++) {
-        for (int col = 0; col < k; col++) {
-            float *s = c + k * row + col;
-            *s = 0;
-            for (int i = 0; i < n; i++)
-                *s += a[row * n + i] * b[col + k * i];
+        float *s = c + SAFE(row) * k;
+        for (int col = 0; col < k; col++)
+            s[col] = 0;
+        for (int i = 0; i < n; i++) {
+            float x = a[SAFE(row) * n + i];
+            const float *bRow = b + SAFE(i) * k;
+            for (int col = 0; col < k; col++)
+                s[col] += x * bRow[col];
         }
     }
 }
@@ -21,43 +30,57 @@ void multiply(float *a, float *b, float *c, int m, int n, int k) {
 namespace omp {
 
 void multiply(float *a, float *b, float *c, int m, int n, int k) {
-#pragma omp parallel for
-    for (int row = 0; row < m; row++) {
-        for (int col = 0; col < k; col++) {
-            float *s = c + k * row + col;
-            *s = 0;
-            for (int i = 0; i < n; i++)
-                *s += a[row * n + i] * b[col + k * i];
-        }
-    }
+    HostGemm::multiply(a, b, c, m, n, k);
 }
 
 } // namespace omp
 
 namespace ocl {
 
-void transpose(float *c, int m, int k, float *cT) {
-    for (int i = 0; i < k; i++)
-        for (int j = 0; j < m; j++)
-            cT[i * m + j] = c[j * k + i];
+static bool useHostPtr(cl_device_id deviceId, Transfer transfer) {
+    if (transfer != Transfer::Auto)
+        return transfer == Transfer::ZeroCopy;
+    cl_bool unified = CL_FALSE;
+    clGetDeviceInfo(deviceId, CL_DEVICE_HOST_UNIFIED_MEMORY, sizeof(cl_bool), &unified, nullptr);
+    return unified == CL_TRUE;
+}
+
+static cl_mem createBuffer(cl_context context, cl_command_queue queue, cl_mem_flags flags, float *data, size_t size,
+                           bool zeroCopy) {
+    if (zeroCopy)
+        return clCreateBuffer(context, flags | CL_MEM_USE_HOST_PTR, size, data, nullptr);
+    cl_mem mem = clCreateBuffer(context, flags, size, nullptr, nullptr);
+    clEnqueueWriteBuffer(queue, mem, CL_TRUE, 0, size, data, 0, nullptr, nullptr);
+    return mem;
 }
 
-void multiply(float *a, float *b, float *c, int m, int n, int k, cl_device_id deviceId, float *elapsed) {
+static void readBuffer(cl_command_queue queue, cl_mem mem, float *data, size_t size, bool zeroCopy) {
+    if (!zeroCopy) {
+        clEnqueueReadBuffer(queue, mem, CL_TRUE, 0, size, data, 0, nullptr, nullptr);
+        return;
+    }
+    void *mapped = clEnqueueMapBuffer(queue, mem, CL_TRUE, CL_MAP_READ, 0, size, 0, nullptr, nullptr, nullptr);
+    clEnqueueUnmapMemObject(queue, mem, mapped, 0, nullptr, nullptr);
+    clFinish(queue);
+}
+
+/**
+ * Runs kernel (a, b, c, m, n, k) from file on buffers created for the host arrays and reads c back,
+ * elapsed gets the kernel time only
+ */
+static void runMultiply(const char *file, const char *name, const std::string &options, float *a, float *b, float *c,
+                        int m, int n, int k, cl_device_id deviceId, const size_t *globalWorkSize,
+                        const size_t *localWorkSize, float *elapsed, Transfer transfer) {
     cl_context context = clCreateContext(nullptr, 1, &deviceId, nullptr, nullptr, nullptr);
     cl_command_queue queue = clCreateCommandQueue(context, deviceId, 0, nullptr);
 
-    std::string source = Utils::readFile(KERNELS_DIR "multiply.cl");
-    const char *strings[] = {source.c_str()};
-    cl_program program = clCreateProgramWithSource(context, 1, strings, nullptr, nullptr);
-    clBuildProgram(program, 1, &deviceId, nullptr, nullptr, nullptr);
-    cl_kernel kernel = clCreateKernel(program, "multiply", nullptr);
+    cl_program program = ProgramCache::build(context, deviceId, file, options);
+    cl_kernel kernel = clCreateKernel(program, name, nullptr);
 
-    cl_mem aMem = clCreateBuffer(context, CL_MEM_READ_ONLY, m * n * sizeof(float), nullptr, nullptr);
-    clEnqueueWriteBuffer(queue, aMem, CL_TRUE, 0, m * n * sizeof(float), a, 0, nullptr, nullptr);
-    cl_mem bMem = clCreateBuffer(context, CL_MEM_READ_ONLY, n * k * sizeof(float), nullptr, nullptr);
-    clEnqueueWriteBuffer(queue, bMem, CL_TRUE, 0, n * k * sizeof(float), b, 0, nullptr, nullptr);
-    cl_mem cMem = clCreateBuffer(context, CL_MEM_READ_WRITE, m * k * sizeof(float), nullptr, nullptr);
-    clEnqueueWriteBuffer(queue, cMem, CL_TRUE, 0, m * k * sizeof(float), c, 0, nullptr, nullptr);
+    bool zeroCopy = useHostPtr(deviceId, transfer);
+    cl_mem aMem = createBuffer(context, queue, CL_MEM_READ_ONLY, a, SAFE(m) * n * sizeof(float), zeroCopy);
+    cl_mem bMem = createBuffer(context, queue, CL_MEM_READ_ONLY, b, SAFE(n) * k * sizeof(float), zeroCopy);
+    cl_mem cMem = createBuffer(context, queue, CL_MEM_READ_WRITE, c, SAFE(m) * k * sizeof(float), zeroCopy);
 
     clSetKernelArg(kernel, 0, sizeof(cl_mem), &aMem);
     clSetKernelArg(kernel, 1, sizeof(cl_mem), &bMem);
@@ -66,15 +89,13 @@ void multiply(float *a, float *b, float *c, int m, int n, int k, cl_device_id de
     clSetKernelArg(kernel, 4, sizeof(int), &n);
     clSetKernelArg(kernel, 5, sizeof(int), &k);
 
-    size_t globalWorkSize[] = {SAFE(m), SAFE(k)};
-    size_t localWorkSize[] = {16u, 16u};
     float begin = omp_get_wtime();
     clEnqueueNDRangeKernel(queue, kernel, 2, nullptr, globalWorkSize, localWorkSize, 0, nullptr, nullptr);
     clFinish(queue);
     float end = omp_get_wtime();
     if (elapsed != nullptr)
         *elapsed = end - begin;
-    clEnqueueReadBuffer(queue, cMem, CL_TRUE, 0, m * k * sizeof(float), c, 0, nullptr, nullptr);
+    readBuffer(queue, cMem, c, SAFE(m) * k * sizeof(float), zeroCopy);
 
     clReleaseMemObject(aMem);
     clReleaseMemObject(bMem);
@@ -85,22 +106,63 @@ void multiply(float *a, float *b, float *c, int m, int n, int k, cl_device_id de
     clReleaseContext(context);
 }
 
-void multiplyBlock(float *a, float *b, float *c, int m, int n, int k, cl_device_id deviceId, float *elapsed) {
+static size_t roundUp(int value, size_t multiple) {
+    return (SAFE(value) + multiple - 1) / multiple * multiple;
+}
+
+void multiply(float *a, float *b, float *c, int m, int n, int k, cl_device_id deviceId, float *elapsed,
+              Transfer transfer) {
+    multiplyTiled(a, b, c, m, n, k, deviceId, elapsed, transfer);
+}
+
+void multiplyBlock(float *a, float *b, float *c, int m, int n, int k, cl_device_id deviceId, float *elapsed,
+                   Transfer transfer) {
+    // multiplyBlockOptimal needs square matrices of a size multiple of the block
+    Tuner::GemmConfig config = Tuner::gemmConfig(deviceId, m, n, k);
+    if (m != n || n != k || m % config.blockSize != 0) {
+        multiplyTiled(a, b, c, m, n, k, deviceId, elapsed, transfer);
+        return;
+    }
+    size_t globalWorkSize[] = {SAFE(m), SAFE(k)};
+    size_t localWorkSize[] = {SAFE(config.blockSize), SAFE(config.blockSize)};
+    runMultiply("multiplyBlock.cl", "multiplyBlockOptimal", config.blockOptions(), a, b, c, m, n, k, deviceId,
+                globalWorkSize, localWorkSize, elapsed, transfer);
+}
+
+void multiplyTiled(float *a, float *b, float *c, int m, int n, int k, cl_device_id deviceId, float *elapsed,
+                   Transfer transfer) {
+    Tuner::GemmConfig config = Tuner::gemmConfig(deviceId, m, n, k);
+    size_t globalWorkSize[] = {(SAFE(k) + config.tileK - 1) / config.tileK * config.localK(),
+                               (SAFE(m) + config.tileM - 1) / config.tileM * config.localM()};
+    size_t localWorkSize[] = {config.localK(), config.localM()};
+    runMultiply("gemm.cl", "gemmTiled", config.options(), a, b, c, m, n, k, deviceId, globalWorkSize, localWorkSize,
+                elapsed, transfer);
+}
+
+void multiplyMixed(float *a, float *b, float *c, int m, int n, int k, Precision::Storage storage,
+                   cl_device_id deviceId, float *elapsed, size_t *bytes) {
+    std::vector<uint16_t> aStored(SAFE(m) * n);
+    std::vector<uint16_t> bStored(SAFE(n) * k);
+    Precision::convert(a, aStored.data(), aStored.size(), storage);
+    Precision::convert(b, bStored.data(), bStored.size(), storage);
+
     cl_context context = clCreateContext(nullptr, 1, &deviceId, nullptr, nullptr, nullptr);
     cl_command_queue queue = clCreateCommandQueue(context, deviceId, 0, nullptr);
 
-    std::string source = Utils::readFile(KERNELS_DIR "multiplyBlock.cl");
-    const char *strings[] = {source.c_str()};
-    cl_program program = clCreateProgramWithSource(context, 1, strings, nullptr, nullptr);
-    clBuildProgram(program, 1, &deviceId, nullptr, nullptr, nullptr);
-    cl_kernel kernel = clCreateKernel(program, "multiplyBlockOptimal", nullptr);
+    Tuner::GemmConfig config = Tuner::gemmConfig(deviceId, m, n, k);
+    std::string options =
+        config.options() + (storage == Precision::Storage::Half ? " -DSTORAGE_HALF" : " -DSTORAGE_BF16");
+    cl_program program = ProgramCache::build(context, deviceId, "gemm.cl", options);
+    cl_kernel kernel = clCreateKernel(program, "gemmTiled", nullptr);
 
-    cl_mem aMem = clCreateBuffer(context, CL_MEM_READ_ONLY, m * n * sizeof(float), nullptr, nullptr);
-    clEnqueueWriteBuffer(queue, aMem, CL_TRUE, 0, m * n * sizeof(float), a, 0, nullptr, nullptr);
-    cl_mem bMem = clCreateBuffer(context, CL_MEM_READ_ONLY, n * k * sizeof(float), nullptr, nullptr);
-    clEnqueueWriteBuffer(queue, bMem, CL_TRUE, 0, n * k * sizeof(float), b, 0, nullptr, nullptr);
-    cl_mem cMem = clCreateBuffer(context, CL_MEM_READ_WRITE, m * k * sizeof(float), nullptr, nullptr);
-    clEnqueueWriteBuffer(queue, cMem, CL_TRUE, 0, m * k * sizeof(float), c, 0, nullptr, nullptr);
+    size_t aSize = aStored.size() * sizeof(uint16_t);
+    size_t bSize = bStored.size() * sizeof(uint16_t);
+    size_t cSize = SAFE(m) * k * sizeof(float);
+    cl_mem aMem = clCreateBuffer(context, CL_MEM_READ_ONLY, aSize, nullptr, nullptr);
+    cl_mem bMem = clCreateBuffer(context, CL_MEM_READ_ONLY, bSize, nullptr, nullptr);
+    cl_mem cMem = clCreateBuffer(context, CL_MEM_WRITE_ONLY, cSize, nullptr, nullptr);
+    clEnqueueWriteBuffer(queue, aMem, CL_FALSE, 0, aSize, aStored.data(), 0, nullptr, nullptr);
+    clEnqueueWriteBuffer(queue, bMem, CL_TRUE, 0, bSize, bStored.data(), 0, nullptr, nullptr);
 
     clSetKernelArg(kernel, 0, sizeof(cl_mem), &aMem);
     clSetKernelArg(kernel, 1, sizeof(cl_mem), &bMem);
@@ -109,15 +171,18 @@ void multiplyBlock(float *a, float *b, float *c, int m, int n, int k, cl_device_
     clSetKernelArg(kernel, 4, sizeof(int), &n);
     clSetKernelArg(kernel, 5, sizeof(int), &k);
 
-    size_t globalWorkSize[] = {SAFE(m), SAFE(k)};
-    size_t localWorkSize[] = {16u, 16u};
+    size_t globalWorkSize[] = {(SAFE(k) + config.tileK - 1) / config.tileK * config.localK(),
+                               (SAFE(m) + config.tileM - 1) / config.tileM * config.localM()};
+    size_t localWorkSize[] = {config.localK(), config.localM()};
     float begin = omp_get_wtime();
     clEnqueueNDRangeKernel(queue, kernel, 2, nullptr, globalWorkSize, localWorkSize, 0, nullptr, nullptr);
     clFinish(queue);
     float end = omp_get_wtime();
     if (elapsed != nullptr)
         *elapsed = end - begin;
-    clEnqueueReadBuffer(queue, cMem, CL_TRUE, 0, m * k * sizeof(float), c, 0, nullptr, nullptr);
+    clEnqueueReadBuffer(queue, cMem, CL_TRUE, 0, cSize, c, 0, nullptr, nullptr);
+    if (bytes != nullptr)
+        *bytes = aSize + bSize + cSize;
 
     clReleaseMemObject(aMem);
     clReleaseMemObject(bMem);
@@ -128,32 +193,38 @@ void multiplyBlock(float *a, float *b, float *c, int m, int n, int k, cl_device_
     clReleaseContext(context);
 }
 
+// Rows x cols matrix in an RGBA float image, rows are padded with zeros to whole texels
+static cl_mem createImage(cl_context context, cl_mem_flags flags, const float *data, int rows, int cols) {
+    size_t width = (SAFE(cols) + 3) / 4;
+    std::vector<float> padded;
+    if (data != nullptr && SAFE(cols) != width * 4) {
+        padded.assign(width * 4 * rows, 0.f);
+        for (int row = 0; row < rows; row++)
+            std::copy(data + SAFE(row) * cols, data + SAFE(row + 1) * cols, padded.begin() + width * 4 * row);
+        data = padded.data();
+    }
+    cl_image_format format;
+    format.image_channel_order = CL_RGBA;
+    format.image_channel_data_type = CL_FLOAT;
+    cl_image_desc desc = {};
+    desc.image_type = CL_MEM_OBJECT_IMAGE2D;
+    desc.image_width = width;
+    desc.image_height = SAFE(rows);
+    if (data != nullptr)
+        flags |= CL_MEM_COPY_HOST_PTR;
+    return clCreateImage(context, flags, &format, &desc, const_cast<float *>(data), nullptr);
+}
+
 void multiplyImage(float *a, float *b, float *c, int m, int n, int k, cl_device_id deviceId, float *elapsed) {
     cl_context context = clCreateContext(nullptr, 1, &deviceId, nullptr, nullptr, nullptr);
     cl_command_queue queue = clCreateCommandQueue(context, deviceId, 0, nullptr);
 
-    std::string source = Utils::readFile(KERNELS_DIR "multiplyImage.cl");
-    const char *strings[] = {source.c_str()};
-    cl_program program = clCreateProgramWithSource(context, 1, strings, nullptr, nullptr);
-    clBuildProgram(program, 1, &deviceId, nullptr, nullptr, nullptr);
+    cl_program program = ProgramCache::build(context, deviceId, "multiplyImage.cl");
     cl_kernel kernel = clCreateKernel(program, "multiplyImage", nullptr);
 
-    cl_image_format format;
-    format.image_channel_order = CL_R;
-    format.image_channel_data_type = CL_FLOAT;
-    size_t origin[] = {0, 0, 0};
-
-    cl_mem aMem = clCreateImage2D(context, CL_MEM_READ_ONLY, &format, SAFE(m), SAFE(n), 0, nullptr, nullptr);
-    cl_mem bMem = clCreateImage2D(context, CL_MEM_READ_ONLY, &format, SAFE(n), SAFE(k), 0, nullptr, nullptr);
-    cl_mem cMem = clCreateImage2D(context, CL_MEM_WRITE_ONLY, &format, SAFE(m), SAFE(k), 0, nullptr, nullptr);
-    {
-        size_t region[] = {SAFE(m), SAFE(n), 1};
-        clEnqueueWriteImage(queue, aMem, CL_TRUE, origin, region, 0, 0, a, 0, nullptr, nullptr);
-    }
-    {
-        size_t region[] = {SAFE(n), SAFE(k), 1};
-        clEnqueueWriteImage(queue, bMem, CL_TRUE, origin, region, 0, 0, b, 0, nullptr, nullptr);
-    }
+    cl_mem aMem = createImage(context, CL_MEM_READ_ONLY, a, m, n);
+    cl_mem bMem = createImage(context, CL_MEM_READ_ONLY, b, n, k);
+    cl_mem cMem = createImage(context, CL_MEM_WRITE_ONLY, nullptr, m, k);
 
     clSetKernelArg(kernel, 0, sizeof(cl_mem), &aMem);
     clSetKernelArg(kernel, 1, sizeof(cl_mem), &bMem);
@@ -162,7 +233,9 @@ void multiplyImage(float *a, float *b, float *c, int m, int n, int k, cl_device_
     clSetKernelArg(kernel, 4, sizeof(int), &n);
     clSetKernelArg(kernel, 5, sizeof(int), &k);
 
-    size_t globalWorkSize[] = {SAFE(m), SAFE(k)};
+    // A work-item covers 4 rows and one texel (4 columns) of c
+    size_t width = (SAFE(k) + 3) / 4;
+    size_t globalWorkSize[] = {roundUp(static_cast<int>(width), 16u), roundUp((m + 3) / 4, 16u)};
     size_t localWorkSize[] = {16u, 16u};
     float begin = omp_get_wtime();
     clEnqueueNDRangeKernel(queue, kernel, 2, nullptr, globalWorkSize, localWorkSize, 0, nullptr, nullptr);
@@ -170,9 +243,16 @@ void multiplyImage(float *a, float *b, float *c, int m, int n, int k, cl_device_
     float end = omp_get_wtime();
     if (elapsed != nullptr)
         *elapsed = end - begin;
-    {
-        size_t region[] = {SAFE(m), SAFE(k), 1};
+
+    size_t origin[] = {0, 0, 0};
+    size_t region[] = {width, SAFE(m), 1};
+    if (width * 4 == SAFE(k)) {
         clEnqueueReadImage(queue, cMem, CL_TRUE, origin, region, 0, 0, c, 0, nullptr, nullptr);
+    } else {
+        std::vector<float> padded(width * 4 * m);
+        clEnqueueReadImage(queue, cMem, CL_TRUE, origin, region, 0, 0, padded.data(), 0, nullptr, nullptr);
+        for (int row = 0; row < m; row++)
+            std::copy(padded.begin() + width * 4 * row, padded.begin() + width * 4 * row + k, c + SAFE(row) * k);
     }
 
     clReleaseMemObject(aMem);
@@ -0,0 +1,169 @@
+#include "multiply.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <omp.h>
+
+#include "programCache.hpp"
+#include "tuner.hpp"
+
+#define SAFE(X) (static_cast<size_t>(X))
+
+namespace ocl {
+
+// Device buffers of one pipeline slot and the panels they currently hold
+struct Slot {
+    cl_command_queue queue;
+    cl_mem a;
+    cl_mem b;
+    cl_mem c;
+    int aRow = -1;
+    int aChunk = -1;
+    int bChunk = -1;
+    int bCol = -1;
+};
+
+static size_t slotSize(int tm, int tn, int tk) {
+    return (SAFE(tm) * tn + SAFE(tn) * tk + SAFE(tm) * tk) * sizeof(float);
+}
+
+/**
+ * Tile of c (tm x tk) and inner chunk tn such that two slots fit the budget. Full inner panels are preferred while
+ * the tile stays reasonably large, since then consecutive tiles share their panels and nothing is accumulated.
+ */
+static void chooseTiles(size_t budget, int m, int n, int k, int &tm, int &tn, int &tk) {
+    constexpr int step = 16;
+    constexpr int minFullTile = 128;
+    int largest = std::max(m, k);
+    for (int t = (largest + step - 1) / step * step; t >= std::min(minFullTile, largest); t -= step) {
+        tm = std::min(t, m);
+        tn = n;
+        tk = std::min(t, k);
+        if (2 * slotSize(tm, tn, tk) <= budget)
+            return;
+    }
+    int t = static_cast<int>(std::sqrt(static_cast<double>(budget / (6 * sizeof(float))))) / step * step;
+    t = std::max(t, step);
+    tm = std::min(t, m);
+    tn = std::min(t, n);
+    tk = std::min(t, k);
+}
+
+// Copies rows x cols block at (row, col) of a host matrix with leading dimension ld into a packed device buffer
+static void uploadBlock(cl_command_queue queue, cl_mem mem, const float *host, int ld, int row, int col, int rows,
+                        int cols) {
+    size_t bufferOrigin[] = {0u, 0u, 0u};
+    size_t hostOrigin[] = {SAFE(col) * sizeof(float), SAFE(row), 0u};
+    size_t region[] = {SAFE(cols) * sizeof(float), SAFE(rows), 1u};
+    clEnqueueWriteBufferRect(queue, mem, CL_FALSE, bufferOrigin, hostOrigin, region, SAFE(cols) * sizeof(float), 0,
+                             SAFE(ld) * sizeof(float), 0, host, 0, nullptr, nullptr);
+}
+
+void multiplyOutOfCore(float *a, float *b, float *c, int m, int n, int k, cl_device_id deviceId, float *elapsed,
+                       size_t budget, size_t *bytes) {
+    if (budget == 0) {
+        cl_ulong globalMemSize = 0;
+        clGetDeviceInfo(deviceId, CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(cl_ulong), &globalMemSize, nullptr);
+        budget = static_cast<size_t>(globalMemSize / 2);
+    }
+    int tm = 0, tn = 0, tk = 0;
+    chooseTiles(budget, m, n, k, tm, tn, tk);
+    int rows = (m + tm - 1) / tm;
+    int cols = (k + tk - 1) / tk;
+    int chunks = (n + tn - 1) / tn;
+
+    cl_context context = clCreateContext(nullptr, 1, &deviceId, nullptr, nullptr, nullptr);
+    Tuner::GemmConfig config = Tuner::gemmConfig(deviceId, tm, tn, tk);
+    cl_program program = ProgramCache::build(context, deviceId, "gemmBlas.cl",
+                                              config.options() + " -DREAL=float -DTRANS_A=0 -DTRANS_B=0");
+    cl_kernel kernel = clCreateKernel(program, "gemm", nullptr);
+
+    Slot slots[2];
+    for (Slot &slot : slots) {
+        slot.queue = clCreateCommandQueue(context, deviceId, 0, nullptr);
+        slot.a = clCreateBuffer(context, CL_MEM_READ_ONLY, SAFE(tm) * tn * sizeof(float), nullptr, nullptr);
+        slot.b = clCreateBuffer(context, CL_MEM_READ_ONLY, SAFE(tn) * tk * sizeof(float), nullptr, nullptr);
+        slot.c = clCreateBuffer(context, CL_MEM_READ_WRITE, SAFE(tm) * tk * sizeof(float), nullptr, nullptr);
+    }
+    size_t moved = 0;
+
+    float begin = omp_get_wtime();
+    // Rows of tiles are walked in a snake order and a slot is picked by tile column, so a slot keeps its a panel
+    // along a row and its b panel across the turn. Each slot is an in-order queue: a panel is overwritten only after
+    // the previous kernel of the slot has used it, while the other slot transfers or computes meanwhile.
+    for (int tile = 0; tile < rows * cols; tile++) {
+        int i = tile / cols;
+        int j = i % 2 == 0 ? tile % cols : cols - 1 - tile % cols;
+        Slot &slot = slots[(cols > 1 ? j : tile) % 2];
+        int curM = std::min(tm, m - i * tm);
+        int curK = std::min(tk, k - j * tk);
+        for (int p = 0; p < chunks; p++) {
+            int curN = std::min(tn, n - p * tn);
+            if (slot.aRow != i || slot.aChunk != p) {
+                uploadBlock(slot.queue, slot.a, a, n, i * tm, p * tn, curM, curN);
+                moved += SAFE(curM) * curN * sizeof(float);
+                slot.aRow = i;
+                slot.aChunk = p;
+            }
+            if (slot.bChunk != p || slot.bCol != j) {
+                uploadBlock(slot.queue, slot.b, b, k, p * tn, j * tk, curN, curK);
+                moved += SAFE(curN) * curK * sizeof(float);
+                slot.bChunk = p;
+                slot.bCol = j;
+            }
+            // Partial products over the inner chunks are accumulated in the device tile
+            float alpha = 1;
+            float beta = p == 0 ? 0.0f : 1.0f;
+            int zero = 0;
+            clSetKernelArg(kernel, 0, sizeof(int), &curM);
+            clSetKernelArg(kernel, 1, sizeof(int), &curK);
+            clSetKernelArg(kernel, 2, sizeof(int), &curN);
+            clSetKernelArg(kernel, 3, sizeof(float), &alpha);
+            clSetKernelArg(kernel, 4, sizeof(cl_mem), &slot.a);
+            clSetKernelArg(kernel, 5, sizeof(int), &zero);
+            clSetKernelArg(kernel, 6, sizeof(int), &curN);
+            clSetKernelArg(kernel, 7, sizeof(cl_mem), &slot.b);
+            clSetKernelArg(kernel, 8, sizeof(int), &zero);
+            clSetKernelArg(kernel, 9, sizeof(int), &curK);
+            clSetKernelArg(kernel, 10, sizeof(float), &beta);
+            clSetKernelArg(kernel, 11, sizeof(cl_mem), &slot.c);
+            clSetKernelArg(kernel, 12, sizeof(int), &zero);
+            clSetKernelArg(kernel, 13, sizeof(int), &curK);
+            clSetKernelArg(kernel, 14, sizeof(int), &zero);
+            clSetKernelArg(kernel, 15, sizeof(int), &zero);
+            clSetKernelArg(kernel, 16, sizeof(int), &zero);
+            size_t globalWorkSize[] = {(SAFE(curK) + config.tileK - 1) / config.tileK * config.localK(),
+                                       (SAFE(curM) + config.tileM - 1) / config.tileM * config.localM(), 1u};
+            size_t localWorkSize[] = {config.localK(), config.localM(), 1u};
+            clEnqueueNDRangeKernel(slot.queue, kernel, 3, nullptr, globalWorkSize, localWorkSize, 0, nullptr,
+                                   nullptr);
+        }
+        size_t bufferOrigin[] = {0u, 0u, 0u};
+        size_t hostOrigin[] = {SAFE(j) * tk * sizeof(float), SAFE(i) * tm, 0u};
+        size_t region[] = {SAFE(curK) * sizeof(float), SAFE(curM), 1u};
+        clEnqueueReadBufferRect(slot.queue, slot.c, CL_FALSE, bufferOrigin, hostOrigin, region,
+                                SAFE(curK) * sizeof(float), 0, SAFE(k) * sizeof(float), 0, c, 0, nullptr, nullptr);
+        moved += SAFE(curM) * curK * sizeof(float);
+        clFlush(slot.queue);
+    }
+    for (Slot &slot : slots)
+        clFinish(slot.queue);
+    float end = omp_get_wtime();
+    if (elapsed != nullptr)
+        *elapsed = end - begin;
+    if (bytes != nullptr)
+        *bytes = moved;
+
+    for (Slot &slot : slots) {
+        clReleaseMemObject(slot.a);
+        clReleaseMemObject(slot.b);
+        clReleaseMemObject(slot.c);
+        clReleaseCommandQueue(slot.queue);
+    }
+    clReleaseKernel(kernel);
+    clReleaseProgram(program);
+    clReleaseContext(context);
+}
+
+} // namespace ocl
@@ -0,0 +1,133 @@
+#include "precision.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_X86
+#endif
+
+namespace Precision {
+
+static uint32_t bits(float value) {
+    uint32_t result = 0;
+    std::memcpy(&result, &value, sizeof(result));
+    return result;
+}
+
+static float fromBits(uint32_t value) {
+    float result = 0;
+    std::memcpy(&result, &value, sizeof(result));
+    return result;
+}
+
+uint16_t toHalf(float value) {
+    uint32_t x = bits(value);
+    uint32_t sign = (x >> 16) & 0x8000u;
+    uint32_t abs = x & 0x7fffffffu;
+    // NaN stays NaN, infinity and everything rounding to at least 65520 becomes infinity
+    if (abs > 0x7f800000u)
+        return static_cast<uint16_t>(sign | 0x7e00u);
+    if (abs >= 0x477ff000u)
+        return static_cast<uint16_t>(sign | 0x7c00u);
+    // Below 2^-14 the result is subnormal, counted in units of 2^-24
+    if (abs < 0x38800000u) {
+        if (abs <= 0x33000000u)
+            return static_cast<uint16_t>(sign);
+        uint32_t mantissa = (abs & 0x7fffffu) | 0x800000u;
+        uint32_t shift = 126u - (abs >> 23);
+        uint32_t result = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1u);
+        uint32_t halfway = 1u << (shift - 1u);
+        if (rest > halfway || (rest == halfway && (result & 1u)))
+            result++;
+        return static_cast<uint16_t>(sign | result);
+    }
+    // Exponent is rebiased from 127 to 15, a mantissa carry correctly moves into the exponent
+    uint32_t result = (abs - 0x38000000u) >> 13;
+    uint32_t rest = abs & 0x1fffu;
+    if (rest > 0x1000u || (rest == 0x1000u && (result & 1u)))
+        result++;
+    return static_cast<uint16_t>(sign | result);
+}
+
+float fromHalf(uint16_t value) {
+    uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+    uint32_t exponent = (value >> 10) & 0x1fu;
+    uint32_t mantissa = value & 0x3ffu;
+    if (exponent == 0) {
+        float result = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign ? -result : result;
+    }
+    if (exponent == 31)
+        return fromBits(sign | 0x7f800000u | (mantissa << 13));
+    return fromBits(sign | ((exponent + 112u) << 23) | (mantissa << 13));
+}
+
+uint16_t toBFloat16(float value) {
+    uint32_t x = bits(value);
+    if ((x & 0x7fffffffu) > 0x7f800000u)
+        return static_cast<uint16_t>((x >> 16) | 0x40u);
+    x += 0x7fffu + ((x >> 16) & 1u);
+    return static_cast<uint16_t>(x >> 16);
+}
+
+float fromBFloat16(uint16_t value) {
+    return fromBits(static_cast<uint32_t>(value) << 16);
+}
+
+#ifdef SIMD_X86
+
+// Payloads of NaNs are not kept by toHalf, so any NaN of the same sign matches
+static bool sameHalf(uint16_t x, uint16_t y) {
+    bool xNan = (x & 0x7fffu) > 0x7c00u;
+    bool yNan = (y & 0x7fffu) > 0x7c00u;
+    return xNan || yNan ? xNan && yNan && (x & 0x8000u) == (y & 0x8000u) : x == y;
+}
+
+__attribute__((target("f16c"))) static long long halfMismatchesF16c() {
+    long long mismatches = 0;
+#pragma omp parallel for reduction(+ : mismatches) schedule(static)
+    for (long long i = 0; i <= 0xffffffffLL; i++) {
+        float value = fromBits(static_cast<uint32_t>(i));
+        if (!sameHalf(toHalf(value), static_cast<uint16_t>(_cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT))))
+            mismatches++;
+    }
+    for (uint32_t i = 0; i <= 0xffffu; i++) {
+        float expected = _cvtsh_ss(static_cast<unsigned short>(i));
+        float value = fromHalf(static_cast<uint16_t>(i));
+        bool same = std::isnan(expected) ? std::isnan(value) && std::signbit(value) == std::signbit(expected)
+                                         : bits(value) == bits(expected);
+        if (!same)
+            mismatches++;
+    }
+    return mismatches;
+}
+
+#endif
+
+long long checkHalf() {
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("f16c"))
+        return halfMismatchesF16c();
+#endif
+    return -1;
+}
+
+void convert(const float *src, uint16_t *dst, size_t size, Storage storage) {
+    const long long count = static_cast<long long>(size);
+#pragma omp parallel for
+    for (long long i = 0; i < count; i++)
+        dst[i] = storage == Storage::Half ? toHalf(src[i]) : toBFloat16(src[i]);
+}
+
+void convert(const uint16_t *src, float *dst, size_t size, Storage storage) {
+    const long long count = static_cast<long long>(size);
+#pragma omp parallel for
+    for (long long i = 0; i < count; i++)
+        dst[i] = storage == Storage::Half ? fromHalf(src[i]) : fromBFloat16(src[i]);
+}
+
+} // namespace Precision
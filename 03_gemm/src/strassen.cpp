@@ -0,0 +1,171 @@
+#include "multiply.hpp"
+
+#include <omp.h>
+
+#include "programCache.hpp"
+#include "tuner.hpp"
+
+#define SAFE(X) (static_cast<size_t>(X))
+
+namespace ocl {
+
+// Square view of a device matrix: element (i, j) is at offset + i * ld + j
+struct View {
+    cl_mem mem;
+    int offset;
+    int ld;
+};
+
+static View quadrant(const View &view, int half, int i, int j) {
+    return {view.mem, view.offset + i * half * view.ld + j * half, view.ld};
+}
+
+struct Recursion {
+    cl_command_queue queue;
+    cl_kernel gemm;
+    cl_kernel geam;
+    Tuner::GemmConfig config;
+    cl_mem arena;
+    int cutoff;
+};
+
+// c = a * b with the register-tiled kernel
+static void baseMultiply(Recursion &r, int size, const View &a, const View &b, const View &c) {
+    float alpha = 1;
+    float beta = 0;
+    int zero = 0;
+    clSetKernelArg(r.gemm, 0, sizeof(int), &size);
+    clSetKernelArg(r.gemm, 1, sizeof(int), &size);
+    clSetKernelArg(r.gemm, 2, sizeof(int), &size);
+    clSetKernelArg(r.gemm, 3, sizeof(float), &alpha);
+    clSetKernelArg(r.gemm, 4, sizeof(cl_mem), &a.mem);
+    clSetKernelArg(r.gemm, 5, sizeof(int), &a.offset);
+    clSetKernelArg(r.gemm, 6, sizeof(int), &a.ld);
+    clSetKernelArg(r.gemm, 7, sizeof(cl_mem), &b.mem);
+    clSetKernelArg(r.gemm, 8, sizeof(int), &b.offset);
+    clSetKernelArg(r.gemm, 9, sizeof(int), &b.ld);
+    clSetKernelArg(r.gemm, 10, sizeof(float), &beta);
+    clSetKernelArg(r.gemm, 11, sizeof(cl_mem), &c.mem);
+    clSetKernelArg(r.gemm, 12, sizeof(int), &c.offset);
+    clSetKernelArg(r.gemm, 13, sizeof(int), &c.ld);
+    clSetKernelArg(r.gemm, 14, sizeof(int), &zero);
+    clSetKernelArg(r.gemm, 15, sizeof(int), &zero);
+    clSetKernelArg(r.gemm, 16, sizeof(int), &zero);
+    size_t globalWorkSize[] = {(SAFE(size) + r.config.tileK - 1) / r.config.tileK * r.config.localK(),
+                               (SAFE(size) + r.config.tileM - 1) / r.config.tileM * r.config.localM(), 1u};
+    size_t localWorkSize[] = {r.config.localK(), r.config.localM(), 1u};
+    clEnqueueNDRangeKernel(r.queue, r.gemm, 3, nullptr, globalWorkSize, localWorkSize, 0, nullptr, nullptr);
+}
+
+// c = alpha * a + beta * b
+static void add(Recursion &r, int size, float alpha, const View &a, float beta, const View &b, const View &c) {
+    clSetKernelArg(r.geam, 0, sizeof(int), &size);
+    clSetKernelArg(r.geam, 1, sizeof(int), &size);
+    clSetKernelArg(r.geam, 2, sizeof(float), &alpha);
+    clSetKernelArg(r.geam, 3, sizeof(cl_mem), &a.mem);
+    clSetKernelArg(r.geam, 4, sizeof(int), &a.offset);
+    clSetKernelArg(r.geam, 5, sizeof(int), &a.ld);
+    clSetKernelArg(r.geam, 6, sizeof(float), &beta);
+    clSetKernelArg(r.geam, 7, sizeof(cl_mem), &b.mem);
+    clSetKernelArg(r.geam, 8, sizeof(int), &b.offset);
+    clSetKernelArg(r.geam, 9, sizeof(int), &b.ld);
+    clSetKernelArg(r.geam, 10, sizeof(cl_mem), &c.mem);
+    clSetKernelArg(r.geam, 11, sizeof(int), &c.offset);
+    clSetKernelArg(r.geam, 12, sizeof(int), &c.ld);
+    size_t globalWorkSize[] = {(SAFE(size) + 15) / 16 * 16, (SAFE(size) + 15) / 16 * 16};
+    size_t localWorkSize[] = {16u, 16u};
+    clEnqueueNDRangeKernel(r.queue, r.geam, 2, nullptr, globalWorkSize, localWorkSize, 0, nullptr, nullptr);
+}
+
+/**
+ * Strassen-Winograd step: 7 half-size products and 15 additions. Temporaries x, y and w of a level take
+ * 3 (size / 2)^2 elements of the arena starting at workspace, deeper levels use the space after them.
+ * Products are stored straight into quadrants of c, so the schedule needs no more temporaries.
+ */
+static void strassen(Recursion &r, int size, const View &a, const View &b, const View &c, int depth,
+                     int workspace) {
+    if (depth == 0 || size % 2 != 0 || size <= r.cutoff) {
+        baseMultiply(r, size, a, b, c);
+        return;
+    }
+    int h = size / 2;
+    View x{r.arena, workspace, h};
+    View y{r.arena, workspace + h * h, h};
+    View w{r.arena, workspace + 2 * h * h, h};
+    int next = workspace + 3 * h * h;
+    View a11 = quadrant(a, h, 0, 0), a12 = quadrant(a, h, 0, 1), a21 = quadrant(a, h, 1, 0), a22 = quadrant(a, h, 1, 1);
+    View b11 = quadrant(b, h, 0, 0), b12 = quadrant(b, h, 0, 1), b21 = quadrant(b, h, 1, 0), b22 = quadrant(b, h, 1, 1);
+    View c11 = quadrant(c, h, 0, 0), c12 = quadrant(c, h, 0, 1), c21 = quadrant(c, h, 1, 0), c22 = quadrant(c, h, 1, 1);
+
+    add(r, h, 1, a11, -1, a21, x);                  // S3
+    add(r, h, 1, b22, -1, b12, y);                  // T3
+    strassen(r, h, x, y, c21, depth - 1, next);     // P7
+    add(r, h, 1, a21, 1, a22, x);                   // S1
+    add(r, h, 1, b12, -1, b11, y);                  // T1
+    strassen(r, h, x, y, c22, depth - 1, next);     // P5
+    add(r, h, 1, x, -1, a11, x);                    // S2
+    add(r, h, 1, b22, -1, y, y);                    // T2
+    strassen(r, h, x, y, c12, depth - 1, next);     // P6
+    add(r, h, 1, a12, -1, x, x);                    // S4
+    strassen(r, h, a11, b11, c11, depth - 1, next); // P1
+    add(r, h, 1, c12, 1, c11, c12);                 // U2 = P1 + P6
+    add(r, h, 1, c21, 1, c12, c21);                 // U3 = U2 + P7
+    add(r, h, 1, c12, 1, c22, c12);                 // U4 = U2 + P5
+    add(r, h, 1, c22, 1, c21, c22);                 // C22 = U3 + P5
+    strassen(r, h, x, b22, w, depth - 1, next);     // P3
+    add(r, h, 1, c12, 1, w, c12);                   // C12 = U4 + P3
+    add(r, h, 1, y, -1, b21, y);                    // T4
+    strassen(r, h, a22, y, w, depth - 1, next);     // P4
+    add(r, h, 1, c21, -1, w, c21);                  // C21 = U3 - P4
+    strassen(r, h, a12, b21, w, depth - 1, next);   // P2
+    add(r, h, 1, c11, 1, w, c11);                   // C11 = P1 + P2
+}
+
+void multiplyStrassen(float *a, float *b, float *c, int m, int n, int k, cl_device_id deviceId, float *elapsed,
+                      int depth, int cutoff) {
+    if (m != n || n != k || m % 2 != 0 || m <= cutoff || depth <= 0) {
+        multiplyTiled(a, b, c, m, n, k, deviceId, elapsed);
+        return;
+    }
+    cl_context context = clCreateContext(nullptr, 1, &deviceId, nullptr, nullptr, nullptr);
+    cl_command_queue queue = clCreateCommandQueue(context, deviceId, 0, nullptr);
+
+    Tuner::GemmConfig config = Tuner::gemmConfig(deviceId, m, n, k);
+    cl_program program = ProgramCache::build(context, deviceId, "gemmBlas.cl",
+                                              config.options() + " -DREAL=float -DTRANS_A=0 -DTRANS_B=0");
+    Recursion r{queue, clCreateKernel(program, "gemm", nullptr), clCreateKernel(program, "geam", nullptr), config,
+                nullptr, cutoff};
+
+    // Workspace of every level that actually recurses
+    size_t arenaSize = 0;
+    for (int size = m, level = 0; level < depth && size % 2 == 0 && size > cutoff; level++, size /= 2)
+        arenaSize += 3 * SAFE(size / 2) * SAFE(size / 2);
+    r.arena = clCreateBuffer(context, CL_MEM_READ_WRITE, arenaSize * sizeof(float), nullptr, nullptr);
+
+    size_t size = SAFE(m) * m * sizeof(float);
+    cl_mem aMem = clCreateBuffer(context, CL_MEM_READ_ONLY, size, nullptr, nullptr);
+    cl_mem bMem = clCreateBuffer(context, CL_MEM_READ_ONLY, size, nullptr, nullptr);
+    cl_mem cMem = clCreateBuffer(context, CL_MEM_READ_WRITE, size, nullptr, nullptr);
+    clEnqueueWriteBuffer(queue, aMem, CL_FALSE, 0, size, a, 0, nullptr, nullptr);
+    clEnqueueWriteBuffer(queue, bMem, CL_TRUE, 0, size, b, 0, nullptr, nullptr);
+
+    float begin = omp_get_wtime();
+    strassen(r, m, View{aMem, 0, m}, View{bMem, 0, m}, View{cMem, 0, m}, depth, 0);
+    clFinish(queue);
+    float end = omp_get_wtime();
+    if (elapsed != nullptr)
+        *elapsed = end - begin;
+    clEnqueueReadBuffer(queue, cMem, CL_TRUE, 0, size, c, 0, nullptr, nullptr);
+
+    clReleaseMemObject(aMem);
+    clReleaseMemObject(bMem);
+    clReleaseMemObject(cMem);
+    clReleaseMemObject(r.arena);
+    clReleaseKernel(r.gemm);
+    clReleaseKernel(r.geam);
+    clReleaseProgram(program);
+    clReleaseCommandQueue(queue);
+    clReleaseContext(context);
+}
+
+} // namespace ocl
@@ -0,0 +1,234 @@
+#include "tuner.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include "programCache.hpp"
+#include "utils.hpp"
+
+#define SAFE(X) (static_cast<size_t>(X))
+
+namespace Tuner {
+
+std::string GemmConfig::options() const {
+    std::ostringstream stream;
+    stream << "-DTILE_M=" << tileM << " -DTILE_K=" << tileK << " -DTILE_N=" << tileN << " -DWPT_M=" << wptM
+           << " -DWPT_K=" << wptK << " -DUNROLL=" << unroll;
+    return stream.str();
+}
+
+std::string GemmConfig::blockOptions() const {
+    return "-DBLOCK_SIZE=" + std::to_string(blockSize);
+}
+
+size_t GemmConfig::localM() const {
+    return SAFE(tileM / wptM);
+}
+
+size_t GemmConfig::localK() const {
+    return SAFE(tileK / wptK);
+}
+
+static std::map<std::string, GemmConfig> configs;
+static bool loaded = false;
+
+static std::string deviceInfo(cl_device_id deviceId, cl_device_info param) {
+    size_t size = 0;
+    clGetDeviceInfo(deviceId, param, 0, nullptr, &size);
+    std::string value(size, '\0');
+    clGetDeviceInfo(deviceId, param, size, value.data(), nullptr);
+    return value.c_str();
+}
+
+// Tuned configurations differ mostly by whether a problem fits caches, so sizes are grouped coarsely
+static std::string sizeClass(int m, int n, int k) {
+    int size = std::max({m, n, k});
+    if (size <= 256)
+        return "small";
+    if (size <= 1024)
+        return "medium";
+    return "large";
+}
+
+static std::string tuningKey(cl_device_id deviceId, int m, int n, int k) {
+    return deviceInfo(deviceId, CL_DEVICE_NAME) + '|' + deviceInfo(deviceId, CL_DRIVER_VERSION) + '|' +
+           sizeClass(m, n, k);
+}
+
+// Tuning file has a line per device and size class: key, tab, then tileM tileK tileN wptM wptK unroll blockSize.
+// blockSize may be missing in files written before it was tuned.
+static void load() {
+    if (loaded)
+        return;
+    loaded = true;
+    std::ifstream file(TUNING_FILE);
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t tab = line.rfind('\t');
+        if (tab == std::string::npos)
+            continue;
+        GemmConfig config;
+        std::istringstream values(line.substr(tab + 1));
+        if (!(values >> config.tileM >> config.tileK >> config.tileN >> config.wptM >> config.wptK >> config.unroll))
+            continue;
+        int blockSize = 0;
+        if (values >> blockSize)
+            config.blockSize = blockSize;
+        configs[line.substr(0, tab)] = config;
+    }
+}
+
+static void store() {
+    std::ofstream file(TUNING_FILE);
+    for (const auto &item : configs) {
+        const GemmConfig &c = item.second;
+        file << item.first << '\t' << c.tileM << ' ' << c.tileK << ' ' << c.tileN << ' ' << c.wptM << ' ' << c.wptK
+             << ' ' << c.unroll << ' ' << c.blockSize << '\n';
+    }
+}
+
+GemmConfig gemmConfig(cl_device_id deviceId, int m, int n, int k) {
+    load();
+    auto it = configs.find(tuningKey(deviceId, m, n, k));
+    return it == configs.end() ? GemmConfig() : it->second;
+}
+
+// Configurations satisfying gemm.cl constraints and device limits on work-group size and local memory
+static std::vector<GemmConfig> candidates(cl_device_id deviceId) {
+    size_t maxGroup = 0;
+    cl_ulong localMem = 0;
+    clGetDeviceInfo(deviceId, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(size_t), &maxGroup, nullptr);
+    clGetDeviceInfo(deviceId, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(cl_ulong), &localMem, nullptr);
+
+    std::vector<GemmConfig> result;
+    for (int tileM : {32, 64, 128})
+        for (int tileK : {32, 64, 128})
+            for (int tileN : {8, 16, 32})
+                for (int wptM : {2, 4, 8})
+                    for (int wptK : {2, 4, 8})
+                        for (int unroll : {1, 4}) {
+                            GemmConfig config{tileM, tileK, tileN, wptM, wptK, unroll};
+                            size_t group = config.localM() * config.localK();
+                            size_t local = SAFE(tileM + tileK) * tileN * sizeof(float);
+                            if (group < 16 || group > std::min<size_t>(maxGroup, 1024u) || local > localMem)
+                                continue;
+                            if (wptM * wptK > 64 || tileN % unroll != 0)
+                                continue;
+                            result.push_back(config);
+                        }
+    return result;
+}
+
+/**
+ * Best of several runs of kernel (a, b, c, m, n, k) measured with profiling events, negative if the variant fails to
+ * build or run
+ */
+static double timeVariant(cl_context context, cl_command_queue queue, cl_device_id deviceId, const char *file,
+                          const char *name, const std::string &options, const size_t *globalWorkSize,
+                          const size_t *localWorkSize, cl_mem aMem, cl_mem bMem, cl_mem cMem, int m, int n, int k) {
+    cl_program program = ProgramCache::build(context, deviceId, file, options);
+    if (program == nullptr)
+        return -1;
+    cl_int ret = CL_SUCCESS;
+    cl_kernel kernel = clCreateKernel(program, name, &ret);
+    if (ret != CL_SUCCESS) {
+        clReleaseProgram(program);
+        return -1;
+    }
+    clSetKernelArg(kernel, 0, sizeof(cl_mem), &aMem);
+    clSetKernelArg(kernel, 1, sizeof(cl_mem), &bMem);
+    clSetKernelArg(kernel, 2, sizeof(cl_mem), &cMem);
+    clSetKernelArg(kernel, 3, sizeof(int), &m);
+    clSetKernelArg(kernel, 4, sizeof(int), &n);
+    clSetKernelArg(kernel, 5, sizeof(int), &k);
+
+    double best = -1;
+    // The first run is a warm-up
+    for (int run = 0; run < 4; run++) {
+        cl_event event = nullptr;
+        ret = clEnqueueNDRangeKernel(queue, kernel, 2, nullptr, globalWorkSize, localWorkSize, 0, nullptr, &event);
+        if (ret != CL_SUCCESS)
+            break;
+        clWaitForEvents(1, &event);
+        cl_ulong start = 0;
+        cl_ulong end = 0;
+        clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, nullptr);
+        clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, nullptr);
+        clReleaseEvent(event);
+        double elapsed = (end - start) * 1e-9;
+        if (run > 0 && (best < 0 || elapsed < best))
+            best = elapsed;
+    }
+    clReleaseKernel(kernel);
+    clReleaseProgram(program);
+    return best;
+}
+
+GemmConfig tuneGemm(cl_device_id deviceId, int m, int n, int k, bool verbose) {
+    cl_context context = clCreateContext(nullptr, 1, &deviceId, nullptr, nullptr, nullptr);
+    cl_command_queue queue = clCreateCommandQueue(context, deviceId, CL_QUEUE_PROFILING_ENABLE, nullptr);
+
+    std::vector<float> a(SAFE(m) * n);
+    std::vector<float> b(SAFE(n) * k);
+    Utils::fillRandomly(a);
+    Utils::fillRandomly(b);
+    cl_mem aMem = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, a.size() * sizeof(float), a.data(),
+                                 nullptr);
+    cl_mem bMem = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, b.size() * sizeof(float), b.data(),
+                                 nullptr);
+    cl_mem cMem = clCreateBuffer(context, CL_MEM_WRITE_ONLY, SAFE(m) * k * sizeof(float), nullptr, nullptr);
+
+    GemmConfig best;
+    double bestTime = -1;
+    for (const GemmConfig &config : candidates(deviceId)) {
+        size_t globalWorkSize[] = {(SAFE(k) + config.tileK - 1) / config.tileK * config.localK(),
+                                   (SAFE(m) + config.tileM - 1) / config.tileM * config.localM()};
+        size_t localWorkSize[] = {config.localK(), config.localM()};
+        double elapsed = timeVariant(context, queue, deviceId, "gemm.cl", "gemmTiled", config.options(),
+                                     globalWorkSize, localWorkSize, aMem, bMem, cMem, m, n, k);
+        if (verbose)
+            std::cout << config.options() << ": " << elapsed << std::endl;
+        if (elapsed > 0 && (bestTime < 0 || elapsed < bestTime)) {
+            best = config;
+            bestTime = elapsed;
+        }
+    }
+
+    // multiplyBlockOptimal only takes square matrices of a size multiple of the block, others keep the default
+    size_t maxGroup = 0;
+    clGetDeviceInfo(deviceId, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(size_t), &maxGroup, nullptr);
+    double bestBlockTime = -1;
+    for (int blockSize : {8, 16, 32}) {
+        if (m != n || n != k || m % blockSize != 0 || SAFE(blockSize) * blockSize > maxGroup)
+            continue;
+        GemmConfig config = best;
+        config.blockSize = blockSize;
+        size_t globalWorkSize[] = {SAFE(m), SAFE(k)};
+        size_t localWorkSize[] = {SAFE(blockSize), SAFE(blockSize)};
+        double elapsed = timeVariant(context, queue, deviceId, "multiplyBlock.cl", "multiplyBlockOptimal",
+                                     config.blockOptions(), globalWorkSize, localWorkSize, aMem, bMem, cMem, m, n, k);
+        if (verbose)
+            std::cout << config.blockOptions() << ": " << elapsed << std::endl;
+        if (elapsed > 0 && (bestBlockTime < 0 || elapsed < bestBlockTime)) {
+            best.blockSize = blockSize;
+            bestBlockTime = elapsed;
+        }
+    }
+
+    clReleaseMemObject(aMem);
+    clReleaseMemObject(bMem);
+    clReleaseMemObject(cMem);
+    clReleaseCommandQueue(queue);
+    clReleaseContext(context);
+
+    load();
+    configs[tuningKey(deviceId, m, n, k)] = best;
+    store();
+    return best;
+}
+
+} // namespace Tuner
@@ -1,5 +1,8 @@
 #include "utils.hpp"
 
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <limits>
@@ -20,11 +23,73 @@ std::string Utils::status(bool ok) {
     return "FAIL";
 }
 
-bool Utils::equals(const std::vector<float> &a, const std::vector<float> &b) {
-    if (a.size() != b.size())
+bool Utils::freivalds(const float *a, const float *b, const float *c, int m, int n, int k, double falsePositive,
+                      double tolerance) {
+    bool finite = true;
+#pragma omp parallel for reduction(&& : finite)
+    for (int i = 0; i < m; i++)
+        for (int j = 0; j < k; j++)
+            finite = finite && std::isfinite(c[static_cast<size_t>(i) * k + j]);
+    if (!finite)
         return false;
-    for (size_t i = 0; i < a.size(); i++)
-        if (std::abs(a[i] - b[i]) >= 1e-2f)
-            return false;
-    return true;
+
+    int rounds = std::max(1, static_cast<int>(std::ceil(-std::log2(falsePositive))));
+    std::vector<double> bSquares(n);
+    std::vector<double> terms(m);
+#pragma omp parallel for
+    for (int p = 0; p < n; p++) {
+        double sum = 0;
+        for (int j = 0; j < k; j++)
+            sum += static_cast<double>(b[static_cast<size_t>(p) * k + j]) * b[static_cast<size_t>(p) * k + j];
+        bSquares[p] = sum;
+    }
+#pragma omp parallel for
+    for (int i = 0; i < m; i++) {
+        double sum = 0;
+        for (int p = 0; p < n; p++)
+            sum += static_cast<double>(a[static_cast<size_t>(i) * n + p]) * a[static_cast<size_t>(i) * n + p] *
+                   bSquares[p];
+        terms[i] = sum;
+    }
+
+    std::random_device rd;
+    std::mt19937 mersenne(rd());
+    std::vector<double> r(k);
+    std::vector<double> br(n);
+    std::vector<double> maxDiff(m);
+    std::vector<double> products(m);
+    for (int round = 0; round < rounds; round++) {
+        for (double &value : r)
+            value = mersenne() & 1 ? 1.0 : -1.0;
+#pragma omp parallel for
+        for (int p = 0; p < n; p++) {
+            double sum = 0;
+            for (int j = 0; j < k; j++)
+                sum += b[static_cast<size_t>(p) * k + j] * r[j];
+            br[p] = sum;
+        }
+#pragma omp parallel for
+        for (int i = 0; i < m; i++) {
+            double abr = 0;
+            for (int p = 0; p < n; p++)
+                abr += a[static_cast<size_t>(i) * n + p] * br[p];
+            double cr = 0;
+            for (int j = 0; j < k; j++)
+                cr += c[static_cast<size_t>(i) * k + j] * r[j];
+            maxDiff[i] = std::max(maxDiff[i], std::abs(abr - cr));
+            products[i] += abr * abr;
+        }
+    }
+
+    // Rounding errors of a float dot product of length n grow as sqrt(n) * FLT_EPSILON times its partial sums, which
+    // are of the size of the exact row for same-signed terms and of the root of the sum of squared terms otherwise.
+    // The mean of (a_i * b * r)^2 estimates the squared norm of the exact row, so c does not loosen its own check.
+    bool ok = true;
+#pragma omp parallel for reduction(&& : ok)
+    for (int i = 0; i < m; i++) {
+        double scale = tolerance * std::sqrt(static_cast<double>(n)) * FLT_EPSILON *
+                       (std::sqrt(products[i] / rounds) + std::sqrt(terms[i]));
+        ok = ok && maxDiff[i] <= scale;
+    }
+    return ok;
 }
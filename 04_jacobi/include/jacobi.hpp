@@ -2,12 +2,89 @@
 
 #include <CL/cl.h>
 
+#include <vector>
+
 struct CompResults {
     int iter = 0;
     double kernelTime = 0;
     double fullTime = 0;
     float convNorm = 0;
+    // Iterations executed after the one meeting the threshold, their results are discarded
+    int wastedIter = 0;
+    // Iterations after which the queue was not drained to decide on convergence
+    int avoidedStalls = 0;
+};
+
+/**
+ * When the convergence norm is examined: EveryIteration waits for it after each iteration, Periodic enqueues
+ * period iterations between blocking checks, Lagged keeps up to period iterations in flight while norms arrive
+ * through non-blocking reads
+ */
+struct ConvergencePolicy {
+    enum Mode { EveryIteration, Periodic, Lagged };
+    Mode mode = EveryIteration;
+    int period = 1;
+};
+
+/**
+ * Iteration kernel: PerRow runs a work-item per row, RowBlock a work-group per block of rows with lanes splitting
+ * the dot products. Auto picks RowBlock for non-CPU devices which n rows cannot keep busy.
+ */
+enum class JacobiKernel { Auto, PerRow, RowBlock };
+
+CompResults jacobi(float *a, float *b, float *x, int n, int iter, float convThreshold, cl_device_id deviceId,
+                   JacobiKernel kernel = JacobiKernel::Auto);
+/**
+ * Matrix prepared once on a device for repeated solves: D^-1 * R with a zero diagonal and D^-1 stay in device
+ * memory, so iterations are x1 = c - (D^-1 * R) * x0 with no branch or division, c = D^-1 * b is formed per solve
+ */
+class JacobiMatrix {
+  public:
+    JacobiMatrix(float *a, int n, cl_device_id deviceId);
+    JacobiMatrix(const JacobiMatrix &) = delete;
+    JacobiMatrix &operator=(const JacobiMatrix &) = delete;
+    ~JacobiMatrix();
+
+    // Iteration and policies of jacobiResident, fullTime excludes the setup
+    CompResults solve(float *b, float *x, int iter, float convThreshold, ConvergencePolicy policy = {},
+                      JacobiKernel kernel = JacobiKernel::Auto);
+    // Transfer of a and computation of D^-1 * R and D^-1
+    double setupTime() const;
+
+  private:
+    int n;
+    cl_device_id deviceId;
+    cl_context context;
+    cl_command_queue queue;
+    cl_program program;
+    cl_mem mMem;
+    cl_mem dInvMem;
+    double setup;
+};
+
+/**
+ * Same iteration with approximations resident on the device: buffers swap roles through kernel arguments and the
+ * relative norm is reduced on the device, so one float per iteration is read back. Speculative iterations of
+ * Periodic and Lagged policies write to a ring of buffers so that the approximation meeting the threshold is kept.
+ * Runs a single solve of a JacobiMatrix, fullTime includes its setup.
+ */
+CompResults jacobiResident(float *a, float *b, float *x, int n, int iter, float convThreshold, cl_device_id deviceId,
+                           ConvergencePolicy policy = {}, JacobiKernel kernel = JacobiKernel::Auto);
+
+// Sparse matrix in compressed rows, unlike the dense layout row i holds A_ij: columns cols[rowPtr[i]..rowPtr[i + 1])
+struct CsrMatrix {
+    int n = 0;
+    std::vector<int> rowPtr;
+    std::vector<int> cols;
+    std::vector<float> values;
 };
 
-CompResults jacobi(float *a, float *b, float *x, int n, int iter, float convThreshold, cl_device_id deviceId);
+/**
+ * Resident iteration over a sparse matrix: the CSR input is converted on the device into ELLPACK slots of D^-1 * R,
+ * stored column-major so that work-items of neighbouring rows read neighbouring addresses. deviceBytes receives the
+ * size of the device copy of the matrix, fullTime includes the conversion.
+ */
+CompResults jacobiSparse(const CsrMatrix &a, float *b, float *x, int iter, float convThreshold, cl_device_id deviceId,
+                         ConvergencePolicy policy = {}, size_t *deviceBytes = nullptr);
 float deviation(float *a, float *b, float *x, int n);
+float deviation(const CsrMatrix &a, float *b, float *x);
@@ -5,3 +5,179 @@ __kernel void jacobi(__global float *a, __global float *b, __global float *x0, _
         s += i != j ? a[j * n + i] * x0[j] : 0;
     x1[i] = (b[i] - s) / a[i * n + i];
 }
+
+#ifndef ROWS
+#define ROWS 16
+#endif
+#ifndef LANES
+#define LANES 16
+#endif
+
+/**
+ * Cooperative variant: a work-group computes ROWS consecutive rows, which are adjacent in memory as a is stored by
+ * columns, and its LANES lanes split j. Tiles of x0 are staged in local memory, lane sums are reduced by a tree.
+ * Returns the sum of a[j * n + i] * x0[j] over j != skip, the term is masked with select so the loop has no branch.
+ */
+float rowBlockSum(__global const float *a, __global const float *x0, int n, int i, int skip, __local float *tile,
+                  __local float *partial) {
+    int row = get_local_id(0);
+    int lane = get_local_id(1);
+    int flat = lane * ROWS + row;
+
+    float s = 0;
+    for (int base = 0; base < n; base += ROWS * LANES) {
+        barrier(CLK_LOCAL_MEM_FENCE);
+        tile[flat] = base + flat < n ? x0[base + flat] : 0;
+        barrier(CLK_LOCAL_MEM_FENCE);
+        int count = min(ROWS * LANES, n - base);
+        if (i < n)
+            for (int t = lane; t < count; t += LANES)
+                s = mad(select(a[(size_t)(base + t) * n + i], 0.0f, base + t == skip), tile[t], s);
+    }
+    partial[flat] = s;
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (int half = LANES / 2; half > 0; half >>= 1) {
+        if (lane < half)
+            partial[flat] += partial[flat + half * ROWS];
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+    return partial[row];
+}
+
+__kernel __attribute__((reqd_work_group_size(ROWS, LANES, 1))) void
+jacobiRowBlock(__global const float *a, __global const float *b, __global const float *x0, __global float *x1, int n) {
+    __local float tile[ROWS * LANES];
+    __local float partial[ROWS * LANES];
+    int i = get_group_id(0) * ROWS + get_local_id(0);
+    float s = rowBlockSum(a, x0, n, i, i, tile, partial);
+    if (get_local_id(1) == 0 && i < n)
+        x1[i] = (b[i] - s) / a[(size_t)i * n + i];
+}
+
+// Setup of JacobiMatrix, step 1: dInv = D^-1
+__kernel void inverseDiagonal(__global const float *a, __global float *dInv, int n) {
+    int i = get_global_id(0);
+    if (i < n)
+        dInv[i] = 1.0f / a[(size_t)i * n + i];
+}
+
+// Setup of JacobiMatrix, step 2: a becomes D^-1 * R in place, its diagonal is zero
+__kernel void scaleOffDiagonal(__global float *a, __global const float *dInv, int n) {
+    int i = get_global_id(0);
+    int j = get_global_id(1);
+    if (i < n && j < n)
+        a[(size_t)j * n + i] = i == j ? 0.0f : a[(size_t)j * n + i] * dInv[i];
+}
+
+// c = D^-1 * b for a right-hand side
+__kernel void scaleRhs(__global const float *b, __global const float *dInv, __global float *c, int n) {
+    int i = get_global_id(0);
+    if (i < n)
+        c[i] = b[i] * dInv[i];
+}
+
+// x1 = c - m * x0 with m = D^-1 * R, branch-free
+__kernel void jacobiScaled(__global const float *m, __global const float *c, __global const float *x0,
+                           __global float *x1, int n) {
+    int i = get_global_id(0);
+    float s = 0;
+    for (int j = 0; j < n; j++)
+        s = mad(m[(size_t)j * n + i], x0[j], s);
+    x1[i] = c[i] - s;
+}
+
+__kernel __attribute__((reqd_work_group_size(ROWS, LANES, 1))) void
+jacobiScaledRowBlock(__global const float *m, __global const float *c, __global const float *x0, __global float *x1,
+                     int n) {
+    __local float tile[ROWS * LANES];
+    __local float partial[ROWS * LANES];
+    int i = get_group_id(0) * ROWS + get_local_id(0);
+    // The diagonal of m is zero, no term has to be masked
+    float s = rowBlockSum(m, x0, n, i, -1, tile, partial);
+    if (get_local_id(1) == 0 && i < n)
+        x1[i] = c[i] - s;
+}
+
+// Sparse setup: CSR rows become ELLPACK slots of D^-1 * R, slot k of row i is at k * n + i so that neighbouring
+// work-items read neighbouring addresses. Rows shorter than width are padded with zeros pointing at column i.
+__kernel void csrToEll(__global const int *rowPtr, __global const int *csrCols, __global const float *csrValues, int n,
+                       int width, __global float *values, __global int *cols, __global float *dInv) {
+    int i = get_global_id(0);
+    if (i >= n)
+        return;
+    float diagonal = 0;
+    for (int p = rowPtr[i]; p < rowPtr[i + 1]; p++)
+        if (csrCols[p] == i)
+            diagonal = csrValues[p];
+    float inverse = 1.0f / diagonal;
+    dInv[i] = inverse;
+    int k = 0;
+    for (int p = rowPtr[i]; p < rowPtr[i + 1]; p++) {
+        if (csrCols[p] != i) {
+            values[(size_t)k * n + i] = csrValues[p] * inverse;
+            cols[(size_t)k * n + i] = csrCols[p];
+            k++;
+        }
+    }
+    for (; k < width; k++) {
+        values[(size_t)k * n + i] = 0;
+        cols[(size_t)k * n + i] = i;
+    }
+}
+
+// x1 = c - m * x0 with m = D^-1 * R in ELLPACK slots
+__kernel void jacobiEll(__global const float *values, __global const int *cols, int width, __global const float *c,
+                        __global const float *x0, __global float *x1, int n) {
+    int i = get_global_id(0);
+    float s = 0;
+    for (int k = 0; k < width; k++)
+        s = mad(values[(size_t)k * n + i], x0[cols[(size_t)k * n + i]], s);
+    x1[i] = c[i] - s;
+}
+
+// Tree sum of two values per work-item, sums end up in scratch[0] and scratch[size]
+void groupSum2(__local float *scratch, float first, float second) {
+    int lid = get_local_id(0);
+    int size = get_local_size(0);
+    scratch[lid] = first;
+    scratch[size + lid] = second;
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (int s = size / 2; s > 0; s >>= 1) {
+        if (lid < s) {
+            scratch[lid] += scratch[lid + s];
+            scratch[size + lid] += scratch[size + lid + s];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+}
+
+// Partial sums of (x0 - x1)^2 and x0^2 of every work-group, scratch holds 2 * local size floats
+__kernel void normPartial(__global const float *x0, __global const float *x1, int n, __global float *partial,
+                          __local float *scratch) {
+    float diff = 0;
+    float length = 0;
+    for (int i = get_global_id(0); i < n; i += get_global_size(0)) {
+        float d = x0[i] - x1[i];
+        diff += d * d;
+        length += x0[i] * x0[i];
+    }
+    groupSum2(scratch, diff, length);
+    if (get_local_id(0) == 0) {
+        partial[2 * get_group_id(0)] = scratch[0];
+        partial[2 * get_group_id(0) + 1] = scratch[get_local_size(0)];
+    }
+}
+
+// Relative norm |x0 - x1| / |x0| from count partial pairs into result[index], launched as a single work-group
+__kernel void normFinal(__global const float *partial, int count, __global float *result, int index,
+                        __local float *scratch) {
+    float diff = 0;
+    float length = 0;
+    for (int i = get_local_id(0); i < count; i += get_local_size(0)) {
+        diff += partial[2 * i];
+        length += partial[2 * i + 1];
+    }
+    groupSum2(scratch, diff, length);
+    if (get_local_id(0) == 0)
+        result[index] = sqrt(scratch[0]) / sqrt(scratch[get_local_size(0)]);
+}
@@ -1,12 +1,19 @@
 #include "jacobi.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <memory>
+#include <thread>
 #include <vector>
 
 #include <omp.h>
 
+#include "programCache.hpp"
 #include "utils.hpp"
 
+#define SAFE(X) (static_cast<size_t>(X))
+
 static inline float vectorLength(const float *x, size_t n) {
     float s = 0;
     for (size_t i = 0; i < n; i++) {
@@ -32,18 +39,59 @@ float norm(const std::vector<float> &x0, const std::vector<float> &x1) {
     return normRel(x0, x1);
 }
 
-CompResults jacobi(float *a, float *b, float *x, int n, int iter, float convThreshold, cl_device_id deviceId) {
+// Work-group shape of jacobiRowBlock, ROWS x LANES in jacobi.cl
+static constexpr size_t rowBlockRows = 16;
+static constexpr size_t rowBlockLanes = 16;
+
+/**
+ * CPU devices vectorize the per-row kernel across rows and have few compute units, so they keep it. Elsewhere n
+ * work-items fill the device only if they outnumber a few work-groups of the maximum size per compute unit.
+ */
+static bool useRowBlock(cl_device_id deviceId, int n) {
+    cl_device_type type = 0;
+    cl_uint units = 1;
+    size_t maxGroup = 1;
+    clGetDeviceInfo(deviceId, CL_DEVICE_TYPE, sizeof(cl_device_type), &type, nullptr);
+    clGetDeviceInfo(deviceId, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), &units, nullptr);
+    clGetDeviceInfo(deviceId, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(size_t), &maxGroup, nullptr);
+    if (type & CL_DEVICE_TYPE_CPU)
+        return false;
+    return SAFE(n) < 4 * SAFE(units) * maxGroup;
+}
+
+// Kernels take (a, b, x0, x1, n), scaled ones (D^-1 * R, D^-1 * b, x0, x1, n), jacobiEll its ELLPACK slots first
+struct JacobiLaunch {
+    cl_kernel kernel;
+    bool rowBlock;
+    size_t global[2];
+    size_t local[2];
+};
+
+static JacobiLaunch jacobiLaunch(cl_program program, cl_device_id deviceId, int n, JacobiKernel choice,
+                                 bool scaled = false) {
+    if (choice == JacobiKernel::PerRow || (choice == JacobiKernel::Auto && !useRowBlock(deviceId, n)))
+        return {clCreateKernel(program, scaled ? "jacobiScaled" : "jacobi", nullptr), false, {SAFE(n), 1u}, {1u, 1u}};
+    return {clCreateKernel(program, scaled ? "jacobiScaledRowBlock" : "jacobiRowBlock", nullptr), true,
+            {(SAFE(n) + rowBlockRows - 1) / rowBlockRows * rowBlockRows, rowBlockLanes},
+            {rowBlockRows, rowBlockLanes}};
+}
+
+static void enqueueJacobi(cl_command_queue queue, const JacobiLaunch &launch, cl_event *event) {
+    clEnqueueNDRangeKernel(queue, launch.kernel, launch.rowBlock ? 2 : 1, nullptr, launch.global,
+                           launch.rowBlock ? launch.local : nullptr, 0, nullptr, event);
+}
+
+CompResults jacobi(float *a, float *b, float *x, int n, int iter, float convThreshold, cl_device_id deviceId,
+                   JacobiKernel choice) {
     CompResults results;
     results.fullTime = omp_get_wtime();
 
     cl_context context = clCreateContext(nullptr, 1, &deviceId, nullptr, nullptr, nullptr);
     cl_command_queue queue = clCreateCommandQueue(context, deviceId, 0, nullptr);
 
-    std::string source = Utils::readFile(KERNELS_DIR "jacobi.cl");
-    const char *strings[] = {source.c_str()};
-    cl_program program = clCreateProgramWithSource(context, 1, strings, nullptr, nullptr);
-    clBuildProgram(program, 1, &deviceId, nullptr, nullptr, nullptr);
-    cl_kernel kernel = clCreateKernel(program, "jacobi", nullptr);
+    cl_program program = ProgramCache::build(context, deviceId, "jacobi.cl");
+    JacobiLaunch launch = jacobiLaunch(program, deviceId, n, choice);
+    cl_kernel kernel = launch.kernel;
 
     size_t vecSize = static_cast<size_t>(n) * sizeof(float);
     cl_mem aMem = clCreateBuffer(context, CL_MEM_READ_ONLY, n * vecSize, nullptr, nullptr);
@@ -69,9 +117,8 @@ CompResults jacobi(float *a, float *b, float *x, int n, int iter, float convThre
     do {
         x0 = x1;
         clEnqueueWriteBuffer(queue, x0Mem, CL_TRUE, 0, vecSize, x0.data(), 0, nullptr, nullptr);
-        size_t globalWorkSize = static_cast<size_t>(n);
         double begin = omp_get_wtime();
-        clEnqueueNDRangeKernel(queue, kernel, 1, nullptr, &globalWorkSize, nullptr, 0, nullptr, nullptr);
+        enqueueJacobi(queue, launch, nullptr);
         clFinish(queue);
         double end = omp_get_wtime();
         results.kernelTime += end - begin;
@@ -95,6 +142,313 @@ CompResults jacobi(float *a, float *b, float *x, int n, int iter, float convThre
     return results;
 }
 
+static size_t reductionLocalSize(cl_kernel kernel, cl_device_id deviceId) {
+    size_t group = 0;
+    clGetKernelWorkGroupInfo(kernel, deviceId, CL_KERNEL_WORK_GROUP_SIZE, sizeof(size_t), &group, nullptr);
+    size_t local = 1;
+    while (local * 2 <= std::min<size_t>(group, 256u))
+        local *= 2;
+    return local;
+}
+
+static void CL_CALLBACK normArrived(cl_event, cl_int, void *flag) {
+    static_cast<std::atomic<bool> *>(flag)->store(true);
+}
+
+JacobiMatrix::JacobiMatrix(float *a, int n, cl_device_id deviceId) : n(n), deviceId(deviceId) {
+    double begin = omp_get_wtime();
+    context = clCreateContext(nullptr, 1, &deviceId, nullptr, nullptr, nullptr);
+    queue = clCreateCommandQueue(context, deviceId, CL_QUEUE_PROFILING_ENABLE, nullptr);
+    program = ProgramCache::build(context, deviceId, "jacobi.cl");
+
+    size_t vecSize = SAFE(n) * sizeof(float);
+    mMem = clCreateBuffer(context, CL_MEM_READ_WRITE, n * vecSize, nullptr, nullptr);
+    clEnqueueWriteBuffer(queue, mMem, CL_FALSE, 0, n * vecSize, a, 0, nullptr, nullptr);
+    dInvMem = clCreateBuffer(context, CL_MEM_READ_WRITE, vecSize, nullptr, nullptr);
+
+    // D^-1 is taken first, so that scaling in place never reads a diagonal element already set to zero
+    cl_kernel inverseKernel = clCreateKernel(program, "inverseDiagonal", nullptr);
+    clSetKernelArg(inverseKernel, 0, sizeof(cl_mem), &mMem);
+    clSetKernelArg(inverseKernel, 1, sizeof(cl_mem), &dInvMem);
+    clSetKernelArg(inverseKernel, 2, sizeof(int), &n);
+    size_t globalWorkSize[] = {(SAFE(n) + 15) / 16 * 16, (SAFE(n) + 15) / 16 * 16};
+    size_t localWorkSize[] = {16u, 16u};
+    clEnqueueNDRangeKernel(queue, inverseKernel, 1, nullptr, globalWorkSize, localWorkSize, 0, nullptr, nullptr);
+    cl_kernel scaleKernel = clCreateKernel(program, "scaleOffDiagonal", nullptr);
+    clSetKernelArg(scaleKernel, 0, sizeof(cl_mem), &mMem);
+    clSetKernelArg(scaleKernel, 1, sizeof(cl_mem), &dInvMem);
+    clSetKernelArg(scaleKernel, 2, sizeof(int), &n);
+    clEnqueueNDRangeKernel(queue, scaleKernel, 2, nullptr, globalWorkSize, localWorkSize, 0, nullptr, nullptr);
+    clFinish(queue);
+    clReleaseKernel(inverseKernel);
+    clReleaseKernel(scaleKernel);
+    setup = omp_get_wtime() - begin;
+}
+
+JacobiMatrix::~JacobiMatrix() {
+    clReleaseMemObject(mMem);
+    clReleaseMemObject(dInvMem);
+    clReleaseProgram(program);
+    clReleaseCommandQueue(queue);
+    clReleaseContext(context);
+}
+
+double JacobiMatrix::setupTime() const {
+    return setup;
+}
+
+/**
+ * Resident iteration shared by the dense and sparse solvers: launch computes x1 from x0, which are bound to its
+ * arguments x0Arg and x0Arg + 1, the other arguments are set by the caller. fullTime is left to the caller.
+ */
+static CompResults iterate(cl_context context, cl_command_queue queue, cl_program program, cl_device_id deviceId,
+                           int n, const JacobiLaunch &launch, cl_uint x0Arg, float *b, float *x, int iter,
+                           float convThreshold, ConvergencePolicy policy) {
+    CompResults results;
+    cl_kernel partialKernel = clCreateKernel(program, "normPartial", nullptr);
+    cl_kernel finalKernel = clCreateKernel(program, "normFinal", nullptr);
+
+    size_t local = reductionLocalSize(partialKernel, deviceId);
+    size_t finalLocal = reductionLocalSize(finalKernel, deviceId);
+    cl_uint units = 1;
+    clGetDeviceInfo(deviceId, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), &units, nullptr);
+    int groups = static_cast<int>(std::max<size_t>(1u, std::min<size_t>(4u * units, (SAFE(n) + local - 1) / local)));
+
+    // Iterations enqueued ahead of the last examined norm, the ring holds one more approximation than that
+    int window = policy.mode == ConvergencePolicy::EveryIteration ? 1 : std::max(1, policy.period);
+    int ringSize = window + 1;
+
+    size_t vecSize = SAFE(n) * sizeof(float);
+    std::vector<cl_mem> xMem(ringSize);
+    for (cl_mem &mem : xMem)
+        mem = clCreateBuffer(context, CL_MEM_READ_WRITE, vecSize, nullptr, nullptr);
+    // The first approximation is b, as in jacobi
+    clEnqueueWriteBuffer(queue, xMem[0], CL_FALSE, 0, vecSize, b, 0, nullptr, nullptr);
+    cl_mem partialMem = clCreateBuffer(context, CL_MEM_READ_WRITE, 2 * SAFE(groups) * sizeof(float), nullptr, nullptr);
+    cl_mem normMem = clCreateBuffer(context, CL_MEM_WRITE_ONLY, SAFE(iter) * sizeof(float), nullptr, nullptr);
+
+    clSetKernelArg(partialKernel, 2, sizeof(int), &n);
+    clSetKernelArg(partialKernel, 3, sizeof(cl_mem), &partialMem);
+    clSetKernelArg(partialKernel, 4, 2 * local * sizeof(float), nullptr);
+    clSetKernelArg(finalKernel, 0, sizeof(cl_mem), &partialMem);
+    clSetKernelArg(finalKernel, 1, sizeof(int), &groups);
+    clSetKernelArg(finalKernel, 2, sizeof(cl_mem), &normMem);
+    clSetKernelArg(finalKernel, 4, 2 * finalLocal * sizeof(float), nullptr);
+
+    results.iter = 0;
+    results.convNorm = 0;
+    results.kernelTime = 0;
+
+    std::vector<float> norms(iter);
+    std::vector<cl_event> kernelEvents(iter, nullptr);
+    std::vector<cl_event> readEvents(iter, nullptr);
+    std::unique_ptr<std::atomic<bool>[]> arrived(new std::atomic<bool>[iter]);
+    for (int i = 0; i < iter; i++)
+        arrived[i] = false;
+
+    // Iteration i reads xMem[i % ringSize] and writes xMem[(i + 1) % ringSize]
+    auto enqueueIteration = [&](int i) {
+        cl_mem x0Mem = xMem[i % ringSize];
+        cl_mem x1Mem = xMem[(i + 1) % ringSize];
+        clSetKernelArg(launch.kernel, x0Arg, sizeof(cl_mem), &x0Mem);
+        clSetKernelArg(launch.kernel, x0Arg + 1, sizeof(cl_mem), &x1Mem);
+        clSetKernelArg(partialKernel, 0, sizeof(cl_mem), &x0Mem);
+        clSetKernelArg(partialKernel, 1, sizeof(cl_mem), &x1Mem);
+        clSetKernelArg(finalKernel, 3, sizeof(int), &i);
+        enqueueJacobi(queue, launch, &kernelEvents[i]);
+        size_t partialWorkSize = SAFE(groups) * local;
+        clEnqueueNDRangeKernel(queue, partialKernel, 1, nullptr, &partialWorkSize, &local, 0, nullptr, nullptr);
+        clEnqueueNDRangeKernel(queue, finalKernel, 1, nullptr, &finalLocal, &finalLocal, 0, nullptr, nullptr);
+        if (policy.mode == ConvergencePolicy::Lagged) {
+            clEnqueueReadBuffer(queue, normMem, CL_FALSE, SAFE(i) * sizeof(float), sizeof(float), &norms[i], 0,
+                                nullptr, &readEvents[i]);
+            clSetEventCallback(readEvents[i], CL_COMPLETE, normArrived, &arrived[i]);
+        }
+    };
+
+    int enqueued = 0;
+    int checked = 0;
+    int converged = -1;
+    int stalls = 0;
+    while (converged < 0 && checked < iter) {
+        while (enqueued < std::min(iter, checked + window))
+            enqueueIteration(enqueued++);
+        int available = checked;
+        if (policy.mode == ConvergencePolicy::Lagged) {
+            clFlush(queue);
+            // Norms that already arrived are examined without blocking, otherwise wait for the oldest one
+            while (available < enqueued && arrived[available])
+                available++;
+            if (available == checked) {
+                if (enqueued == checked + 1)
+                    stalls++;
+                clWaitForEvents(1, &readEvents[checked]);
+                available++;
+            }
+        } else {
+            clEnqueueReadBuffer(queue, normMem, CL_TRUE, SAFE(checked) * sizeof(float),
+                                SAFE(enqueued - checked) * sizeof(float), &norms[checked], 0, nullptr, nullptr);
+            stalls++;
+            available = enqueued;
+        }
+        for (; checked < available && converged < 0; checked++) {
+            results.convNorm = norms[checked];
+            if (results.convNorm <= convThreshold)
+                converged = checked;
+        }
+    }
+    clFinish(queue);
+    // Callbacks may run after the reads complete, the flags have to outlive them
+    if (policy.mode == ConvergencePolicy::Lagged)
+        for (int i = 0; i < enqueued; i++)
+            while (!arrived[i])
+                std::this_thread::yield();
+
+    results.iter = converged >= 0 ? converged + 1 : checked;
+    results.wastedIter = enqueued - results.iter;
+    results.avoidedStalls = enqueued - stalls;
+    for (int i = 0; i < enqueued; i++) {
+        cl_ulong begin = 0;
+        cl_ulong end = 0;
+        clGetEventProfilingInfo(kernelEvents[i], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &begin, nullptr);
+        clGetEventProfilingInfo(kernelEvents[i], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, nullptr);
+        results.kernelTime += (end - begin) * 1e-9;
+        clReleaseEvent(kernelEvents[i]);
+        if (readEvents[i] != nullptr)
+            clReleaseEvent(readEvents[i]);
+    }
+    clEnqueueReadBuffer(queue, xMem[results.iter % ringSize], CL_TRUE, 0, vecSize, x, 0, nullptr, nullptr);
+
+    for (cl_mem mem : xMem)
+        clReleaseMemObject(mem);
+    clReleaseMemObject(partialMem);
+    clReleaseMemObject(normMem);
+    clReleaseKernel(partialKernel);
+    clReleaseKernel(finalKernel);
+    return results;
+}
+
+// c = D^-1 * b, scaled in place after the upload
+static cl_mem rightHandSide(cl_context context, cl_command_queue queue, cl_program program, cl_mem dInvMem, float *b,
+                            int n) {
+    size_t vecSize = SAFE(n) * sizeof(float);
+    cl_mem cMem = clCreateBuffer(context, CL_MEM_READ_WRITE, vecSize, nullptr, nullptr);
+    clEnqueueWriteBuffer(queue, cMem, CL_FALSE, 0, vecSize, b, 0, nullptr, nullptr);
+    cl_kernel kernel = clCreateKernel(program, "scaleRhs", nullptr);
+    clSetKernelArg(kernel, 0, sizeof(cl_mem), &cMem);
+    clSetKernelArg(kernel, 1, sizeof(cl_mem), &dInvMem);
+    clSetKernelArg(kernel, 2, sizeof(cl_mem), &cMem);
+    clSetKernelArg(kernel, 3, sizeof(int), &n);
+    size_t globalWorkSize = (SAFE(n) + 15) / 16 * 16;
+    size_t localWorkSize = 16;
+    clEnqueueNDRangeKernel(queue, kernel, 1, nullptr, &globalWorkSize, &localWorkSize, 0, nullptr, nullptr);
+    clReleaseKernel(kernel);
+    return cMem;
+}
+
+CompResults JacobiMatrix::solve(float *b, float *x, int iter, float convThreshold, ConvergencePolicy policy,
+                                JacobiKernel choice) {
+    double begin = omp_get_wtime();
+    cl_mem cMem = rightHandSide(context, queue, program, dInvMem, b, n);
+    JacobiLaunch launch = jacobiLaunch(program, deviceId, n, choice, true);
+    clSetKernelArg(launch.kernel, 0, sizeof(cl_mem), &mMem);
+    clSetKernelArg(launch.kernel, 1, sizeof(cl_mem), &cMem);
+    clSetKernelArg(launch.kernel, 4, sizeof(int), &n);
+
+    CompResults results = iterate(context, queue, program, deviceId, n, launch, 2, b, x, iter, convThreshold, policy);
+
+    clReleaseMemObject(cMem);
+    clReleaseKernel(launch.kernel);
+    results.fullTime = omp_get_wtime() - begin;
+    return results;
+}
+
+CompResults jacobiResident(float *a, float *b, float *x, int n, int iter, float convThreshold, cl_device_id deviceId,
+                           ConvergencePolicy policy, JacobiKernel choice) {
+    double begin = omp_get_wtime();
+    JacobiMatrix matrix(a, n, deviceId);
+    CompResults results = matrix.solve(b, x, iter, convThreshold, policy, choice);
+    results.fullTime = omp_get_wtime() - begin;
+    return results;
+}
+
+CompResults jacobiSparse(const CsrMatrix &a, float *b, float *x, int iter, float convThreshold, cl_device_id deviceId,
+                         ConvergencePolicy policy, size_t *deviceBytes) {
+    double begin = omp_get_wtime();
+    int n = a.n;
+    int nnz = a.rowPtr[n];
+    // Slots per row: the longest row without its diagonal
+    int width = 0;
+    for (int i = 0; i < n; i++) {
+        int count = 0;
+        for (int p = a.rowPtr[i]; p < a.rowPtr[i + 1]; p++)
+            if (a.cols[p] != i)
+                count++;
+        width = std::max(width, count);
+    }
+
+    cl_context context = clCreateContext(nullptr, 1, &deviceId, nullptr, nullptr, nullptr);
+    cl_command_queue queue = clCreateCommandQueue(context, deviceId, CL_QUEUE_PROFILING_ENABLE, nullptr);
+    cl_program program = ProgramCache::build(context, deviceId, "jacobi.cl");
+
+    size_t slotCount = std::max<size_t>(1u, SAFE(width) * n);
+    cl_mem rowPtrMem = clCreateBuffer(context, CL_MEM_READ_ONLY, (SAFE(n) + 1) * sizeof(int), nullptr, nullptr);
+    size_t entryCount = std::max<size_t>(1u, SAFE(nnz));
+    cl_mem csrColsMem = clCreateBuffer(context, CL_MEM_READ_ONLY, entryCount * sizeof(int), nullptr, nullptr);
+    cl_mem csrValuesMem = clCreateBuffer(context, CL_MEM_READ_ONLY, entryCount * sizeof(float), nullptr, nullptr);
+    clEnqueueWriteBuffer(queue, rowPtrMem, CL_FALSE, 0, (SAFE(n) + 1) * sizeof(int), a.rowPtr.data(), 0, nullptr,
+                         nullptr);
+    clEnqueueWriteBuffer(queue, csrColsMem, CL_FALSE, 0, SAFE(nnz) * sizeof(int), a.cols.data(), 0, nullptr, nullptr);
+    clEnqueueWriteBuffer(queue, csrValuesMem, CL_FALSE, 0, SAFE(nnz) * sizeof(float), a.values.data(), 0, nullptr,
+                         nullptr);
+    cl_mem valuesMem = clCreateBuffer(context, CL_MEM_READ_WRITE, slotCount * sizeof(float), nullptr, nullptr);
+    cl_mem colsMem = clCreateBuffer(context, CL_MEM_READ_WRITE, slotCount * sizeof(int), nullptr, nullptr);
+    cl_mem dInvMem = clCreateBuffer(context, CL_MEM_READ_WRITE, SAFE(n) * sizeof(float), nullptr, nullptr);
+
+    cl_kernel convertKernel = clCreateKernel(program, "csrToEll", nullptr);
+    clSetKernelArg(convertKernel, 0, sizeof(cl_mem), &rowPtrMem);
+    clSetKernelArg(convertKernel, 1, sizeof(cl_mem), &csrColsMem);
+    clSetKernelArg(convertKernel, 2, sizeof(cl_mem), &csrValuesMem);
+    clSetKernelArg(convertKernel, 3, sizeof(int), &n);
+    clSetKernelArg(convertKernel, 4, sizeof(int), &width);
+    clSetKernelArg(convertKernel, 5, sizeof(cl_mem), &valuesMem);
+    clSetKernelArg(convertKernel, 6, sizeof(cl_mem), &colsMem);
+    clSetKernelArg(convertKernel, 7, sizeof(cl_mem), &dInvMem);
+    size_t globalWorkSize = (SAFE(n) + 15) / 16 * 16;
+    size_t localWorkSize = 16;
+    clEnqueueNDRangeKernel(queue, convertKernel, 1, nullptr, &globalWorkSize, &localWorkSize, 0, nullptr, nullptr);
+    // The CSR copy is not needed once converted
+    clFinish(queue);
+    clReleaseMemObject(rowPtrMem);
+    clReleaseMemObject(csrColsMem);
+    clReleaseMemObject(csrValuesMem);
+    clReleaseKernel(convertKernel);
+    if (deviceBytes != nullptr)
+        *deviceBytes = slotCount * (sizeof(float) + sizeof(int)) + SAFE(n) * sizeof(float);
+
+    cl_mem cMem = rightHandSide(context, queue, program, dInvMem, b, n);
+    // One work-item per row, as the per-row dense kernel
+    JacobiLaunch launch = {clCreateKernel(program, "jacobiEll", nullptr), false, {SAFE(n), 1u}, {1u, 1u}};
+    clSetKernelArg(launch.kernel, 0, sizeof(cl_mem), &valuesMem);
+    clSetKernelArg(launch.kernel, 1, sizeof(cl_mem), &colsMem);
+    clSetKernelArg(launch.kernel, 2, sizeof(int), &width);
+    clSetKernelArg(launch.kernel, 3, sizeof(cl_mem), &cMem);
+    clSetKernelArg(launch.kernel, 6, sizeof(int), &n);
+
+    CompResults results = iterate(context, queue, program, deviceId, n, launch, 4, b, x, iter, convThreshold, policy);
+
+    clReleaseMemObject(valuesMem);
+    clReleaseMemObject(colsMem);
+    clReleaseMemObject(dInvMem);
+    clReleaseMemObject(cMem);
+    clReleaseKernel(launch.kernel);
+    clReleaseProgram(program);
+    clReleaseCommandQueue(queue);
+    clReleaseContext(context);
+    results.fullTime = omp_get_wtime() - begin;
+    return results;
+}
+
 static inline float deviationAbs(float *a, float *b, float *x, int n) {
     float norm = 0;
     for (int i = 0; i < n; i++) {
@@ -115,3 +469,16 @@ static inline float deviationRel(float *a, float *b, float *x, int n) {
 float deviation(float *a, float *b, float *x, int n) {
     return deviationRel(a, b, x, n);
 }
+
+float deviation(const CsrMatrix &a, float *b, float *x) {
+    float norm = 0;
+    for (int i = 0; i < a.n; i++) {
+        float s = 0;
+        for (int p = a.rowPtr[i]; p < a.rowPtr[i + 1]; p++) {
+            s += a.values[p] * x[a.cols[p]];
+        }
+        s -= b[i];
+        norm += s * s;
+    }
+    return sqrt(norm) / vectorLength(b, a.n);
+}
@@ -2,14 +2,17 @@
 #define KERNELS_DIR
 #endif
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <random>
+#include <utility>
 #include <vector>
 
 #include <CL/cl.h>
 
 #include "jacobi.hpp"
+#include "programCache.hpp"
 #include "utils.hpp"
 
 int main() {
@@ -69,6 +72,119 @@ int main() {
         std::cout << "Convergency norm: " << results.convNorm << std::endl;
         std::cout << "Deviation: " << deviation(a.data(), b.data(), x.data(), n) << std::endl;
     }
+    for (cl_device_id deviceId : {cpuDeviceId, gpuDeviceId}) {
+        std::vector<float> x(n, 0);
+        CompResults results = jacobiResident(a.data(), b.data(), x.data(), n, iter, convThreshold, deviceId);
+        std::cout << "------" << std::endl;
+        std::cout << (deviceId == cpuDeviceId ? "OpenCL CPU" : "OpenCL GPU") << " resident" << std::endl;
+        std::cout << "Iterations: " << results.iter << std::endl;
+        std::cout << "Kernel time: " << results.kernelTime << std::endl;
+        std::cout << "Full time: " << results.fullTime << std::endl;
+        std::cout << "Convergency norm: " << results.convNorm << std::endl;
+        std::cout << "Deviation: " << deviation(a.data(), b.data(), x.data(), n) << std::endl;
+    }
+    for (cl_device_id deviceId : {cpuDeviceId, gpuDeviceId}) {
+        std::cout << "------" << std::endl;
+        std::cout << (deviceId == cpuDeviceId ? "OpenCL CPU" : "OpenCL GPU")
+                  << " resident kernels (kernel time, full time, deviation)" << std::endl;
+        double perRowTime = 0;
+        for (JacobiKernel kernel : {JacobiKernel::PerRow, JacobiKernel::RowBlock}) {
+            std::vector<float> x(n, 0);
+            CompResults results =
+                jacobiResident(a.data(), b.data(), x.data(), n, iter, convThreshold, deviceId, {}, kernel);
+            std::cout << (kernel == JacobiKernel::PerRow ? "Per row:   " : "Row block: ") << results.kernelTime << ", "
+                      << results.fullTime << ", " << deviation(a.data(), b.data(), x.data(), n);
+            if (kernel == JacobiKernel::PerRow)
+                perRowTime = results.kernelTime;
+            else
+                std::cout << ", speedup " << perRowTime / results.kernelTime;
+            std::cout << std::endl;
+        }
+    }
+    {
+        std::cout << "------" << std::endl;
+        std::cout << "OpenCL GPU resident convergence policies (full time, iterations, wasted, avoided stalls)"
+                  << std::endl;
+        const std::pair<const char *, ConvergencePolicy> policies[] = {
+            {"Every iteration: ", {ConvergencePolicy::EveryIteration, 1}},
+            {"Periodic 5:      ", {ConvergencePolicy::Periodic, 5}},
+            {"Periodic 20:     ", {ConvergencePolicy::Periodic, 20}},
+            {"Lagged 2:        ", {ConvergencePolicy::Lagged, 2}},
+            {"Lagged 4:        ", {ConvergencePolicy::Lagged, 4}},
+        };
+        for (const auto &[name, policy] : policies) {
+            std::vector<float> x(n, 0);
+            CompResults results =
+                jacobiResident(a.data(), b.data(), x.data(), n, iter, convThreshold, gpuDeviceId, policy);
+            std::cout << name << results.fullTime << ", " << results.iter << ", " << results.wastedIter << ", "
+                      << results.avoidedStalls << ", deviation: " << deviation(a.data(), b.data(), x.data(), n)
+                      << std::endl;
+        }
+    }
+    {
+        // Setup of the prepared matrix is paid once, every new right-hand side is only scaled and iterated
+        JacobiMatrix matrix(a.data(), n, gpuDeviceId);
+        std::cout << "------" << std::endl;
+        std::cout << "OpenCL GPU prepared matrix, setup time: " << matrix.setupTime() << std::endl;
+        for (int rhs = 0; rhs < 3; rhs++) {
+            std::vector<float> bNext(n);
+            Utils::fillRandomly(bNext);
+            std::vector<float> x(n, 0);
+            CompResults results = matrix.solve(bNext.data(), x.data(), iter, convThreshold);
+            std::cout << "Right-hand side " << rhs << ": " << results.kernelTime << ", iters: " << results.iter
+                      << ", full time: " << results.fullTime
+                      << ", deviation: " << deviation(a.data(), bNext.data(), x.data(), n) << std::endl;
+        }
+    }
+
+    {
+        std::cout << "------" << std::endl;
+        std::cout << "OpenCL GPU sparse vs dense on banded matrices (matrix bytes, time per iteration, deviation)"
+                  << std::endl;
+        std::random_device rd;
+        std::mt19937 mersenne(rd());
+        std::uniform_real_distribution<> urd(1.0, 3.0);
+        for (int halfBand : {2, 16, 64}) {
+            // Diagonal dominant by a factor of two over the off-diagonal entries of its row
+            CsrMatrix sparse;
+            sparse.n = n;
+            sparse.rowPtr.push_back(0);
+            std::vector<float> dense(static_cast<size_t>(n) * n, 0);
+            for (int i = 0; i < n; i++) {
+                float offDiagonal = 0;
+                int diagonal = 0;
+                for (int j = std::max(0, i - halfBand); j <= std::min(n - 1, i + halfBand); j++) {
+                    float value = j == i ? 0.0f : static_cast<float>(urd(mersenne));
+                    if (j == i)
+                        diagonal = static_cast<int>(sparse.values.size());
+                    offDiagonal += value;
+                    sparse.cols.push_back(j);
+                    sparse.values.push_back(value);
+                }
+                sparse.values[diagonal] = 2 * offDiagonal + 1;
+                for (int p = sparse.rowPtr.back(); p < static_cast<int>(sparse.values.size()); p++)
+                    dense[static_cast<size_t>(sparse.cols[p]) * n + i] = sparse.values[p];
+                sparse.rowPtr.push_back(static_cast<int>(sparse.values.size()));
+            }
+
+            std::vector<float> x(n, 0);
+            CompResults results =
+                jacobiResident(dense.data(), b.data(), x.data(), n, iter, convThreshold, gpuDeviceId);
+            std::cout << "Half band " << halfBand << ", dense:  " << (n + 1u) * n * sizeof(float) << ", "
+                      << results.kernelTime / results.iter << ", " << deviation(dense.data(), b.data(), x.data(), n)
+                      << std::endl;
+            std::fill(x.begin(), x.end(), 0.0f);
+            size_t sparseBytes = 0;
+            results = jacobiSparse(sparse, b.data(), x.data(), iter, convThreshold, gpuDeviceId, {}, &sparseBytes);
+            std::cout << "Half band " << halfBand << ", sparse: " << sparseBytes << ", "
+                      << results.kernelTime / results.iter << ", " << deviation(sparse, b.data(), x.data())
+                      << std::endl;
+        }
+    }
+
+    const ProgramCache::Stats &cacheStats = ProgramCache::stats();
+    std::cout << "------\nProgram cache: " << cacheStats.hits << " hits, " << cacheStats.misses
+              << " misses, build time " << cacheStats.buildTime << std::endl;
 
     delete[] platform;
 }
@@ -7,9 +7,29 @@ struct CompResults {
     double kernelTime = 0;
     double fullTime = 0;
     float convNorm = 0;
+    // Iterations executed after the one meeting the threshold, their results are discarded
+    int wastedIter = 0;
+    // Iterations after which the queues were not drained to decide on convergence
+    int avoidedStalls = 0;
+};
+
+/**
+ * When the convergence norm is examined: EveryIteration after each iteration, Periodic only every period
+ * iterations, Lagged while the next iteration already runs on the devices
+ */
+struct ConvergencePolicy {
+    enum Mode { EveryIteration, Periodic, Lagged };
+    Mode mode = EveryIteration;
+    int period = 1;
 };
 
 CompResults jacobi(float *a, float *b, float *x, int n, int iter, float convThreshold, cl_device_id deviceId);
+/**
+ * Rows below delim are computed on the CPU device and the rest on the GPU device, halves are exchanged through the
+ * host every iteration. The exchange is chained with events, so the host only waits to compute the norm. The norm is
+ * computed on the host, so with Periodic the overshoot of up to period - 1 iterations is not measured and
+ * wastedIter stays 0.
+ */
 CompResults jacobiHetero(float *a, float *b, float *x, int n, int iter, float convThreshold, int delim,
-                         cl_device_id cpuDeviceId, cl_device_id gpuDeviceId);
+                         cl_device_id cpuDeviceId, cl_device_id gpuDeviceId, ConvergencePolicy policy = {});
 float deviation(float *a, float *b, float *x, int n);
@@ -1,10 +1,13 @@
 #include "jacobi.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <utility>
 #include <vector>
 
 #include <omp.h>
 
+#include "programCache.hpp"
 #include "utils.hpp"
 
 static inline float vectorLength(const float *x, size_t n) {
@@ -32,6 +35,10 @@ float norm(const std::vector<float> &x0, const std::vector<float> &x1) {
     return normRel(x0, x1);
 }
 
+static void CL_CALLBACK halfArrived(cl_event, cl_int, void *userEvent) {
+    clSetUserEventStatus(static_cast<cl_event>(userEvent), CL_COMPLETE);
+}
+
 CompResults jacobi(float *a, float *b, float *x, int n, int iter, float convThreshold, cl_device_id deviceId) {
     CompResults results;
     results.fullTime = omp_get_wtime();
@@ -39,10 +46,7 @@ CompResults jacobi(float *a, float *b, float *x, int n, int iter, float convThre
     cl_context context = clCreateContext(nullptr, 1, &deviceId, nullptr, nullptr, nullptr);
     cl_command_queue queue = clCreateCommandQueue(context, deviceId, 0, nullptr);
 
-    std::string source = Utils::readFile(KERNELS_DIR "jacobi.cl");
-    const char *strings[] = {source.c_str()};
-    cl_program program = clCreateProgramWithSource(context, 1, strings, nullptr, nullptr);
-    clBuildProgram(program, 1, &deviceId, nullptr, nullptr, nullptr);
+    cl_program program = ProgramCache::build(context, deviceId, "jacobi.cl");
     cl_kernel kernel = clCreateKernel(program, "jacobi", nullptr);
 
     size_t vecSize = static_cast<size_t>(n) * sizeof(float);
@@ -96,7 +100,7 @@ CompResults jacobi(float *a, float *b, float *x, int n, int iter, float convThre
 }
 
 CompResults jacobiHetero(float *a, float *b, float *x, int n, int iter, float convThreshold, int delim,
-                         cl_device_id cpuDeviceId, cl_device_id gpuDeviceId) {
+                         cl_device_id cpuDeviceId, cl_device_id gpuDeviceId, ConvergencePolicy policy) {
     CompResults results;
     results.fullTime = omp_get_wtime();
 
@@ -105,12 +109,8 @@ CompResults jacobiHetero(float *a, float *b, float *x, int n, int iter, float co
     cl_command_queue cpuQueue = clCreateCommandQueue(cpuContext, cpuDeviceId, CL_QUEUE_PROFILING_ENABLE, nullptr);
     cl_command_queue gpuQueue = clCreateCommandQueue(gpuContext, gpuDeviceId, CL_QUEUE_PROFILING_ENABLE, nullptr);
 
-    std::string source = Utils::readFile(KERNELS_DIR "jacobi.cl");
-    const char *strings[] = {source.c_str()};
-    cl_program cpuProgram = clCreateProgramWithSource(cpuContext, 1, strings, nullptr, nullptr);
-    cl_program gpuProgram = clCreateProgramWithSource(gpuContext, 1, strings, nullptr, nullptr);
-    clBuildProgram(cpuProgram, 1, &cpuDeviceId, nullptr, nullptr, nullptr);
-    clBuildProgram(gpuProgram, 1, &gpuDeviceId, nullptr, nullptr, nullptr);
+    cl_program cpuProgram = ProgramCache::build(cpuContext, cpuDeviceId, "jacobi.cl");
+    cl_program gpuProgram = ProgramCache::build(gpuContext, gpuDeviceId, "jacobi.cl");
     cl_kernel cpuKernel = clCreateKernel(cpuProgram, "jacobi", nullptr);
     cl_kernel gpuKernel = clCreateKernel(gpuProgram, "jacobi", nullptr);
 
@@ -148,48 +148,101 @@ CompResults jacobiHetero(float *a, float *b, float *x, int n, int iter, float co
     results.convNorm = 0;
     results.kernelTime = 0;
 
-    std::vector<float> x0(0, n);
-    std::vector<float> x1(b, b + n);
+    // Iteration i reads xs[i % 3] and writes xs[(i + 1) % 3], the third vector keeps the input of a checked iteration
+    // intact while the next one already runs with Lagged policy
+    std::vector<std::vector<float>> xs(3, std::vector<float>(n));
+    std::copy(b, b + n, xs[0].begin());
     size_t cpuWorkSize = static_cast<size_t>(delim);
     size_t gpuWorkSize = static_cast<size_t>(n - delim);
     size_t cpuOffset = 0;
     size_t gpuOffset = static_cast<size_t>(delim);
 
-    cl_event events[2];
-    cl_ulong cpuTime[2], gpuTime[2];
-    double times[2] = {0};
-
-    do {
-        x0 = x1;
-        clEnqueueWriteBuffer(cpuQueue, x0MemCpu, CL_FALSE, 0, vecSize, x0.data(), 0, nullptr, nullptr);
-        clEnqueueWriteBuffer(gpuQueue, x0MemGpu, CL_FALSE, 0, vecSize, x0.data(), 0, nullptr, nullptr);
-        clFinish(cpuQueue);
-        clFinish(gpuQueue);
-
-        clEnqueueNDRangeKernel(cpuQueue, cpuKernel, 1, &cpuOffset, &cpuWorkSize, nullptr, 0, nullptr, events + 0);
-        clEnqueueNDRangeKernel(gpuQueue, gpuKernel, 1, &gpuOffset, &gpuWorkSize, nullptr, 0, nullptr, events + 1);
-        clWaitForEvents(2, events);
-        clFinish(cpuQueue);
-        clFinish(gpuQueue);
-
-        clGetEventProfilingInfo(events[0], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), cpuTime, nullptr);
-        clGetEventProfilingInfo(events[0], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), cpuTime + 1, nullptr);
-        clGetEventProfilingInfo(events[1], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), gpuTime, nullptr);
-        clGetEventProfilingInfo(events[1], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), gpuTime + 1, nullptr);
-        times[0] = (cpuTime[1] - cpuTime[0]) / 1e9;
-        times[1] = (gpuTime[1] - gpuTime[0]) / 1e9;
-        results.kernelTime += times[0] > times[1] ? times[0] : times[1];
+    // Per device (0 is CPU, 1 is GPU) and iteration. The contexts differ, so a half arriving on the host completes a
+    // user event of the other context, which the write of the next iteration waits on.
+    std::vector<cl_event> kernelEvents[2];
+    std::vector<cl_event> readEvents[2];
+    std::vector<cl_event> arrivedEvents[2];
+    for (int device = 0; device < 2; device++) {
+        kernelEvents[device].resize(iter);
+        readEvents[device].resize(iter);
+        arrivedEvents[device].resize(iter);
+    }
 
-        clEnqueueReadBuffer(cpuQueue, x1MemCpu, CL_FALSE, 0, delim * sizeof(float), x1.data(), 0, nullptr, nullptr);
+    // Iterations are chained on the in-order queues and through the user events, the host only waits for a check
+    auto enqueueIteration = [&](int i) {
+        const float *in = xs[i % 3].data();
+        float *out = xs[(i + 1) % 3].data();
+        cl_uint waitCount = i > 0 ? 1 : 0;
+        clEnqueueWriteBuffer(cpuQueue, x0MemCpu, CL_FALSE, 0, vecSize, in, waitCount,
+                             i > 0 ? &arrivedEvents[1][i - 1] : nullptr, nullptr);
+        clEnqueueWriteBuffer(gpuQueue, x0MemGpu, CL_FALSE, 0, vecSize, in, waitCount,
+                             i > 0 ? &arrivedEvents[0][i - 1] : nullptr, nullptr);
+        clEnqueueNDRangeKernel(cpuQueue, cpuKernel, 1, &cpuOffset, &cpuWorkSize, nullptr, 0, nullptr,
+                               &kernelEvents[0][i]);
+        clEnqueueNDRangeKernel(gpuQueue, gpuKernel, 1, &gpuOffset, &gpuWorkSize, nullptr, 0, nullptr,
+                               &kernelEvents[1][i]);
+        clEnqueueReadBuffer(cpuQueue, x1MemCpu, CL_FALSE, 0, delim * sizeof(float), out, 0, nullptr,
+                            &readEvents[0][i]);
         clEnqueueReadBuffer(gpuQueue, x1MemGpu, CL_FALSE, delim * sizeof(float), vecSize - delim * sizeof(float),
-                            x1.data() + delim, 0, nullptr, nullptr);
-        clFinish(cpuQueue);
-        clFinish(gpuQueue);
-        results.convNorm = norm(x0, x1);
-    } while (++results.iter < iter && results.convNorm > convThreshold);
+                            out + delim, 0, nullptr, &readEvents[1][i]);
+        arrivedEvents[0][i] = clCreateUserEvent(gpuContext, nullptr);
+        arrivedEvents[1][i] = clCreateUserEvent(cpuContext, nullptr);
+        clSetEventCallback(readEvents[0][i], CL_COMPLETE, halfArrived, arrivedEvents[0][i]);
+        clSetEventCallback(readEvents[1][i], CL_COMPLETE, halfArrived, arrivedEvents[1][i]);
+        clFlush(cpuQueue);
+        clFlush(gpuQueue);
+    };
+
+    // Periodic examines every period-th iteration, Lagged keeps the next iteration queued while the host decides
+    int period = policy.mode == ConvergencePolicy::Periodic ? std::max(1, policy.period) : 1;
+    int ahead = policy.mode == ConvergencePolicy::Lagged ? 1 : 0;
+    int enqueued = 0;
+    int checked = 0;
+    int converged = -1;
+    int stalls = 0;
+    while (converged < 0 && checked < iter) {
+        int target = std::min(iter, checked + period);
+        while (enqueued < std::min(iter, target + ahead))
+            enqueueIteration(enqueued++);
+        // Nothing else is queued, so the devices idle until the host decides
+        if (enqueued == target)
+            stalls++;
+        clWaitForEvents(1, &readEvents[0][target - 1]);
+        clWaitForEvents(1, &readEvents[1][target - 1]);
+        checked = target;
+        results.convNorm = norm(xs[(target - 1) % 3], xs[target % 3]);
+        if (results.convNorm <= convThreshold)
+            converged = target;
+    }
+    clFinish(cpuQueue);
+    clFinish(gpuQueue);
+    // Callbacks may run after the reads complete, the user events have to outlive them
+    clWaitForEvents(enqueued, arrivedEvents[0].data());
+    clWaitForEvents(enqueued, arrivedEvents[1].data());
+
+    results.iter = converged >= 0 ? converged : checked;
+    results.wastedIter = enqueued - results.iter;
+    results.avoidedStalls = enqueued - stalls;
+    for (int i = 0; i < enqueued; i++) {
+        double times[2] = {0};
+        for (int device = 0; device < 2; device++) {
+            cl_ulong begin = 0;
+            cl_ulong end = 0;
+            clGetEventProfilingInfo(kernelEvents[device][i], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &begin,
+                                    nullptr);
+            clGetEventProfilingInfo(kernelEvents[device][i], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end,
+                                    nullptr);
+            times[device] = (end - begin) / 1e9;
+            clReleaseEvent(kernelEvents[device][i]);
+            clReleaseEvent(readEvents[device][i]);
+            clReleaseEvent(arrivedEvents[device][i]);
+        }
+        results.kernelTime += times[0] > times[1] ? times[0] : times[1];
+    }
 
+    const std::vector<float> &result = xs[results.iter % 3];
     for (int i = 0; i < n; i++)
-        x[i] = x1[i];
+        x[i] = result[i];
 
     clReleaseMemObject(aMemCpu);
     clReleaseMemObject(bMemCpu);
@@ -10,6 +10,7 @@
 
 #include "jacobi.hpp"
 #include "multiply.hpp"
+#include "programCache.hpp"
 #include "utils.hpp"
 
 int main() {
@@ -37,23 +38,27 @@ int main() {
         Utils::fillRandomly(a);
         Utils::fillRandomly(b);
         std::cout << std::defaultfloat << std::setprecision(6);
+        // Freivalds' check is O(n^2), a reference product would cost more than the runs themselves
+        auto verify = [&](const std::vector<float> &c) {
+            return Utils::freivalds(a.data(), b.data(), c.data(), n, n, n);
+        };
         {
             std::vector<float> c(n * n, 0);
             float elapsed = 0;
             ocl::multiply(a.data(), b.data(), c.data(), n, cpuDeviceId, &elapsed);
-            std::cout << "OpenCL CPU: " << elapsed << std::endl;
+            std::cout << "OpenCL CPU: " << elapsed << ' ' << Utils::status(verify(c)) << std::endl;
         }
         {
             std::vector<float> c(n * n, 0);
             float elapsed = 0;
             ocl::multiply(a.data(), b.data(), c.data(), n, gpuDeviceId, &elapsed);
-            std::cout << "OpenCL GPU: " << elapsed << std::endl;
+            std::cout << "OpenCL GPU: " << elapsed << ' ' << Utils::status(verify(c)) << std::endl;
         }
         {
             std::vector<float> c(n * n, 0);
             float elapsed = 0;
             ocl::multiplyHetero(a.data(), b.data(), c.data(), n, 16 * 16, cpuDeviceId, gpuDeviceId, &elapsed);
-            std::cout << "OpenCL CPU+GPU: " << elapsed << std::endl;
+            std::cout << "OpenCL CPU+GPU: " << elapsed << ' ' << Utils::status(verify(c)) << std::endl;
         }
     }
     std::cout << "------" << std::endl;
@@ -98,7 +103,21 @@ int main() {
                       << ", full time: " << results.fullTime << ", conv norm: " << results.convNorm
                       << ", deviation: " << deviation(a.data(), b.data(), x.data(), n) << std::endl;
         }
+        for (ConvergencePolicy policy :
+             {ConvergencePolicy{ConvergencePolicy::Periodic, 10}, ConvergencePolicy{ConvergencePolicy::Lagged, 1}}) {
+            std::vector<float> x(n, 0);
+            CompResults results = jacobiHetero(a.data(), b.data(), x.data(), n, iter, convThreshold, 400, cpuDeviceId,
+                                               gpuDeviceId, policy);
+            std::cout << (policy.mode == ConvergencePolicy::Periodic ? "Periodic 10:    " : "Lagged:         ")
+                      << results.kernelTime << ", iters: " << results.iter << ", full time: " << results.fullTime
+                      << ", wasted: " << results.wastedIter << ", avoided stalls: " << results.avoidedStalls
+                      << ", deviation: " << deviation(a.data(), b.data(), x.data(), n) << std::endl;
+        }
     }
 
+    const ProgramCache::Stats &cacheStats = ProgramCache::stats();
+    std::cout << "------\nProgram cache: " << cacheStats.hits << " hits, " << cacheStats.misses
+              << " misses, build time " << cacheStats.buildTime << std::endl;
+
     delete[] platform;
 }
@@ -3,6 +3,7 @@
 #include <omp.h>
 #include <string>
 
+#include "programCache.hpp"
 #include "utils.hpp"
 
 #define SAFE(X) (static_cast<size_t>(X))
@@ -24,10 +25,7 @@ void multiply(float *a, float *b, float *c, int n, cl_device_id deviceId, float
     cl_context context = clCreateContext(nullptr, 1, &deviceId, nullptr, nullptr, nullptr);
     cl_command_queue queue = clCreateCommandQueue(context, deviceId, 0, nullptr);
 
-    std::string source = Utils::readFile(KERNELS_DIR "multiply.cl");
-    const char *strings[] = {source.c_str()};
-    cl_program program = clCreateProgramWithSource(context, 1, strings, nullptr, nullptr);
-    clBuildProgram(program, 1, &deviceId, nullptr, nullptr, nullptr);
+    cl_program program = ProgramCache::build(context, deviceId, "multiply.cl");
     cl_kernel kernel = clCreateKernel(program, "multiply", nullptr);
 
     size_t byteSize = n * n * sizeof(float);
@@ -70,12 +68,8 @@ void multiplyHetero(float *a, float *b, float *c, int n, int delim, cl_device_id
     cl_command_queue cpuQueue = clCreateCommandQueue(cpuContext, cpuDeviceId, CL_QUEUE_PROFILING_ENABLE, &ret);
     cl_command_queue gpuQueue = clCreateCommandQueue(gpuContext, gpuDeviceId, CL_QUEUE_PROFILING_ENABLE, &ret);
 
-    std::string source = Utils::readFile(KERNELS_DIR "multiply.cl");
-    const char *strings[] = {source.c_str()};
-    cl_program cpuProgram = clCreateProgramWithSource(cpuContext, 1, strings, nullptr, &ret);
-    ret = clBuildProgram(cpuProgram, 1, &cpuDeviceId, nullptr, nullptr, nullptr);
-    cl_program gpuProgram = clCreateProgramWithSource(gpuContext, 1, strings, nullptr, &ret);
-    ret = clBuildProgram(gpuProgram, 1, &gpuDeviceId, nullptr, nullptr, nullptr);
+    cl_program cpuProgram = ProgramCache::build(cpuContext, cpuDeviceId, "multiply.cl");
+    cl_program gpuProgram = ProgramCache::build(gpuContext, gpuDeviceId, "multiply.cl");
     cl_kernel cpuKernel = clCreateKernel(cpuProgram, "multiply", &ret);
     cl_kernel gpuKernel = clCreateKernel(gpuProgram, "multiply", &ret);
 
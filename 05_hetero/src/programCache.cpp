@@ -0,0 +1,116 @@
+#include "programCache.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include <omp.h>
+
+#include "utils.hpp"
+
+static ProgramCache::Stats cacheStats;
+
+static std::string hash(const std::string &data) {
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : data) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(16, '0');
+    for (int i = 15; i >= 0; i--, h >>= 4)
+        hex[i] = digits[h & 0xf];
+    return hex;
+}
+
+static std::string deviceInfo(cl_device_id deviceId, cl_device_info param) {
+    size_t size = 0;
+    clGetDeviceInfo(deviceId, param, 0, nullptr, &size);
+    std::string value(size, '\0');
+    clGetDeviceInfo(deviceId, param, size, value.data(), nullptr);
+    return value.c_str();
+}
+
+static cl_program loadBinary(cl_context context, cl_device_id deviceId, const std::string &path,
+                             const std::string &key, const std::string &options) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return nullptr;
+    std::vector<unsigned char> content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    // Binary file starts with the null-terminated key it was built for
+    size_t headerSize = key.size() + 1;
+    if (content.size() <= headerSize || std::string(content.begin(), content.begin() + headerSize) != key + '\0')
+        return nullptr;
+
+    const unsigned char *binary = content.data() + headerSize;
+    size_t binarySize = content.size() - headerSize;
+    cl_int status = CL_SUCCESS;
+    cl_int ret = CL_SUCCESS;
+    cl_program program = clCreateProgramWithBinary(context, 1, &deviceId, &binarySize, &binary, &status, &ret);
+    if (ret != CL_SUCCESS || status != CL_SUCCESS) {
+        if (program != nullptr)
+            clReleaseProgram(program);
+        return nullptr;
+    }
+    if (clBuildProgram(program, 1, &deviceId, options.c_str(), nullptr, nullptr) != CL_SUCCESS) {
+        clReleaseProgram(program);
+        return nullptr;
+    }
+    return program;
+}
+
+static void storeBinary(cl_program program, const std::string &path, const std::string &key) {
+    size_t binarySize = 0;
+    if (clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(size_t), &binarySize, nullptr) != CL_SUCCESS ||
+        binarySize == 0)
+        return;
+    std::vector<unsigned char> binary(binarySize);
+    unsigned char *binaries[] = {binary.data()};
+    if (clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(binaries), binaries, nullptr) != CL_SUCCESS)
+        return;
+
+    std::error_code error;
+    std::filesystem::create_directories(CACHE_DIR, error);
+    // Write to a unique temporary file first so that concurrent runs never read a partial binary
+    std::string tmpPath = path + '.' + hash(key + std::to_string(omp_get_wtime())) + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary);
+        file.write(key.c_str(), key.size() + 1);
+        file.write(reinterpret_cast<char *>(binary.data()), binary.size());
+        if (!file)
+            return;
+    }
+    std::filesystem::rename(tmpPath, path, error);
+    if (error)
+        std::filesystem::remove(tmpPath, error);
+}
+
+cl_program ProgramCache::build(cl_context context, cl_device_id deviceId, const std::string &file,
+                               const std::string &options) {
+    double begin = omp_get_wtime();
+
+    std::string source = Utils::readFile(KERNELS_DIR + file);
+    std::string key = deviceInfo(deviceId, CL_DEVICE_NAME) + '\n' + deviceInfo(deviceId, CL_DRIVER_VERSION) + '\n' +
+                      options + '\n' + hash(source);
+    std::string path = CACHE_DIR + hash(key) + ".bin";
+
+    cl_program program = loadBinary(context, deviceId, path, key, options);
+    if (program != nullptr) {
+        cacheStats.hits++;
+    } else {
+        const char *strings[] = {source.c_str()};
+        program = clCreateProgramWithSource(context, 1, strings, nullptr, nullptr);
+        if (clBuildProgram(program, 1, &deviceId, options.c_str(), nullptr, nullptr) == CL_SUCCESS)
+            storeBinary(program, path, key);
+        cacheStats.misses++;
+    }
+
+    cacheStats.buildTime += omp_get_wtime() - begin;
+    return program;
+}
+
+const ProgramCache::Stats &ProgramCache::stats() {
+    return cacheStats;
+}